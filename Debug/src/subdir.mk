@@ -5,41 +5,95 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/Dted_Acc.cpp \
+../src/Dted_Archive.cpp \
+../src/Dted_Async_Reader.cpp \
 ../src/Dted_Cell.cpp \
+../src/Dted_Cell_Grid.cpp \
+../src/Dted_Cell_Loader.cpp \
 ../src/Dted_Cell_Path_Entry.cpp \
+../src/Dted_Compressed_Posts.cpp \
+../src/Dted_Coverage.cpp \
 ../src/Dted_Database.cpp \
 ../src/Dted_Directory.cpp \
 ../src/Dted_Dsi.cpp \
+../src/Dted_Epoch.cpp \
 ../src/Dted_Hdr.cpp \
+../src/Dted_Min_Max_Tree.cpp \
+../src/Dted_Numa.cpp \
+../src/Dted_Overview.cpp \
+../src/Dted_Packed_Converter.cpp \
+../src/Dted_Page_Cache.cpp \
+../src/Dted_Query_Router.cpp \
 ../src/Dted_Record.cpp \
+../src/Dted_Shared_Cache.cpp \
+../src/Dted_Tile_Arena.cpp \
+../src/Dted_Tile_Store.cpp \
+../src/Dted_Trajectory_Prefetcher.cpp \
 ../src/Dted_Uhl.cpp \
 ../src/Dted_Vol.cpp \
+../src/Dted_Working_Set.cpp \
 ../src/Endian.cpp 
 
 OBJS += \
 ./src/Dted_Acc.o \
+./src/Dted_Archive.o \
+./src/Dted_Async_Reader.o \
 ./src/Dted_Cell.o \
+./src/Dted_Cell_Grid.o \
+./src/Dted_Cell_Loader.o \
 ./src/Dted_Cell_Path_Entry.o \
+./src/Dted_Compressed_Posts.o \
+./src/Dted_Coverage.o \
 ./src/Dted_Database.o \
 ./src/Dted_Directory.o \
 ./src/Dted_Dsi.o \
+./src/Dted_Epoch.o \
 ./src/Dted_Hdr.o \
+./src/Dted_Min_Max_Tree.o \
+./src/Dted_Numa.o \
+./src/Dted_Overview.o \
+./src/Dted_Packed_Converter.o \
+./src/Dted_Page_Cache.o \
+./src/Dted_Query_Router.o \
 ./src/Dted_Record.o \
+./src/Dted_Shared_Cache.o \
+./src/Dted_Tile_Arena.o \
+./src/Dted_Tile_Store.o \
+./src/Dted_Trajectory_Prefetcher.o \
 ./src/Dted_Uhl.o \
 ./src/Dted_Vol.o \
+./src/Dted_Working_Set.o \
 ./src/Endian.o 
 
 CPP_DEPS += \
 ./src/Dted_Acc.d \
+./src/Dted_Archive.d \
+./src/Dted_Async_Reader.d \
 ./src/Dted_Cell.d \
+./src/Dted_Cell_Grid.d \
+./src/Dted_Cell_Loader.d \
 ./src/Dted_Cell_Path_Entry.d \
+./src/Dted_Compressed_Posts.d \
+./src/Dted_Coverage.d \
 ./src/Dted_Database.d \
 ./src/Dted_Directory.d \
 ./src/Dted_Dsi.d \
+./src/Dted_Epoch.d \
 ./src/Dted_Hdr.d \
+./src/Dted_Min_Max_Tree.d \
+./src/Dted_Numa.d \
+./src/Dted_Overview.d \
+./src/Dted_Packed_Converter.d \
+./src/Dted_Page_Cache.d \
+./src/Dted_Query_Router.d \
 ./src/Dted_Record.d \
+./src/Dted_Shared_Cache.d \
+./src/Dted_Tile_Arena.d \
+./src/Dted_Tile_Store.d \
+./src/Dted_Trajectory_Prefetcher.d \
 ./src/Dted_Uhl.d \
 ./src/Dted_Vol.d \
+./src/Dted_Working_Set.d \
 ./src/Endian.d 
 
 
@@ -0,0 +1,265 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Single file archive of packed Dted cells.
+//
+//********************************************************************
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "Dted_Archive.h"
+#include "Dted_Cell.h"
+#include "Dted_Packed_Format.h"
+
+Dted_Archive::Dted_Archive() :
+        mappedRegion(NULL),
+        mappedSize(0),
+        archiveBase(NULL),
+        archiveSize(0),
+        index(NULL),
+        cellCount(0) {
+}
+
+Dted_Archive::~Dted_Archive() {
+    Close();
+}
+
+void Dted_Archive::Close() {
+    if (mappedRegion != NULL)
+        munmap(mappedRegion, mappedSize);
+
+    mappedRegion = NULL;
+    mappedSize = 0;
+    archiveBase = NULL;
+    archiveSize = 0;
+    index = NULL;
+    cellCount = 0;
+}
+
+bool Dted_Archive::Is_Archive(const string& path) {
+    char magic[sizeof(((Header*) 0)->magic)];
+    ifstream archiveStr(path.c_str(), ios::in | ios::binary);
+
+    if (!archiveStr.is_open())
+        return false;
+
+    archiveStr.read(magic, sizeof(magic));
+
+    return (archiveStr.gcount() == (streamsize) sizeof(magic))
+            && (memcmp(magic, "DTEDARCH", sizeof(magic)) == 0);
+}
+
+bool Dted_Archive::Open(const string& path, unsigned long long offset) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+
+    if ((fstat(fd, &fileStat) != 0)
+            || ((unsigned long long) fileStat.st_size
+                    < offset + Dted_Packed_Header::PAGE_SIZE)) {
+        close(fd);
+        return false;
+    }
+
+    void* region = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (region == MAP_FAILED)
+        return false;
+
+    mappedRegion = (unsigned char*) region;
+    mappedSize = fileStat.st_size;
+    archiveBase = mappedRegion + offset;
+    archiveSize = mappedSize - offset;
+
+    const Header* header = (const Header*) archiveBase;
+
+    if ((memcmp(header->magic, "DTEDARCH", sizeof(header->magic)) != 0)
+            || (header->version != Header::VERSION)
+            || (header->byteOrder != Dted_Packed_Header::BYTE_ORDER_MARK)
+            || (header->indexOffset > archiveSize)
+            || (header->cellCount
+                    > (archiveSize - header->indexOffset) / sizeof(Index_Entry))) {
+        Close();
+        return false;
+    }
+
+    index = (const Index_Entry*) (archiveBase + header->indexOffset);
+    cellCount = header->cellCount;
+
+    for (int i = 0; i < cellCount; i++) {
+        if ((index[i].offset > archiveSize)
+                || (index[i].size > archiveSize - index[i].offset)) {
+            Close();
+            return false;
+        }
+    }
+
+    archivePath = path;
+
+    return true;
+}
+
+const string& Dted_Archive::Get_Path() const {
+    return archivePath;
+}
+
+int Dted_Archive::Get_Cell_Count() const {
+    return cellCount;
+}
+
+const Dted_Archive::Index_Entry& Dted_Archive::Get_Entry(int i) const {
+    return index[i];
+}
+
+const Dted_Archive::Index_Entry* Dted_Archive::Find(short latitude,
+        short longitude) const {
+    int low = 0;
+    int high = cellCount - 1;
+
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        const Index_Entry& entry = index[middle];
+
+        if ((entry.latitude < latitude)
+                || ((entry.latitude == latitude)
+                        && (entry.longitude < longitude)))
+            low = middle + 1;
+        else if ((entry.latitude == latitude)
+                && (entry.longitude == longitude))
+            return &entry;
+        else
+            high = middle - 1;
+    }
+
+    return NULL;
+}
+
+const unsigned char* Dted_Archive::Get_Cell_Image(
+        const Index_Entry& entry) const {
+    return archiveBase + entry.offset;
+}
+
+int Dted_Archive::Build(const vector<Dted_Cell_Path_Entry>& cellEntries,
+        const string& path) {
+    vector<Dted_Cell_Path_Entry> sortedEntries(cellEntries);
+    sort(sortedEntries.begin(), sortedEntries.end());
+    sortedEntries.erase(unique(sortedEntries.begin(), sortedEntries.end()),
+            sortedEntries.end());
+
+    // Write aside and rename so readers never map a partial archive.
+    string tempPath = path + ".tmp";
+    ofstream archiveStr(tempPath.c_str(),
+            ios::out | ios::binary | ios::trunc);
+
+    if (!archiveStr.is_open())
+        return -1;
+
+    int failed = Write(sortedEntries,
+            vector<Dted_Cell*>(sortedEntries.size(), (Dted_Cell*) NULL),
+            archiveStr);
+
+    archiveStr.close();
+
+    if ((failed < 0) || archiveStr.fail()
+            || (rename(tempPath.c_str(), path.c_str()) != 0)) {
+        unlink(tempPath.c_str());
+        return -1;
+    }
+
+    return failed;
+}
+
+int Dted_Archive::Write(const vector<Dted_Cell_Path_Entry>& cellEntries,
+        const vector<Dted_Cell*>& cells, ostream& archiveStr) {
+    unsigned long long start = archiveStr.tellp();
+
+    char page[Dted_Packed_Header::PAGE_SIZE];
+    memset(page, 0, sizeof(page));
+
+    // Header placeholder, rewritten once the index is known.
+    archiveStr.write(page, sizeof(page));
+
+    vector<Index_Entry> archiveIndex;
+    int failed = 0;
+
+    for (size_t i = 0; i < cellEntries.size(); i++) {
+        const Dted_Cell_Path_Entry& cellEntry = cellEntries[i];
+        Dted_Cell* dtedCellPtr = cells[i];
+
+        if (dtedCellPtr == NULL)
+            dtedCellPtr =
+                    cellEntry.archive ?
+                            new Dted_Cell(cellEntry.archive,
+                                    cellEntry.latitude, cellEntry.longitude) :
+                            new Dted_Cell(cellEntry.cellPath);
+
+        Index_Entry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.latitude = cellEntry.latitude;
+        entry.longitude = cellEntry.longitude;
+        entry.offset = (unsigned long long) archiveStr.tellp() - start;
+
+        bool written = dtedCellPtr->writePacked(archiveStr);
+
+        if (dtedCellPtr != cells[i])
+            delete dtedCellPtr;
+
+        if (!written) {
+            cerr << "ERROR: Can not archive: '" << cellEntry.cellPath << "'"
+                    << endl;
+            failed++;
+            continue;
+        }
+
+        entry.size = (unsigned long long) archiveStr.tellp() - start
+                - entry.offset;
+        archiveIndex.push_back(entry);
+
+        // Keep every cell on a page boundary.
+        size_t padding = (Dted_Packed_Header::PAGE_SIZE
+                - entry.size % Dted_Packed_Header::PAGE_SIZE)
+                % Dted_Packed_Header::PAGE_SIZE;
+        archiveStr.write(page, padding);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "DTEDARCH", sizeof(header.magic));
+    header.version = Header::VERSION;
+    header.byteOrder = Dted_Packed_Header::BYTE_ORDER_MARK;
+    header.cellCount = archiveIndex.size();
+    header.indexOffset = (unsigned long long) archiveStr.tellp() - start;
+
+    if (!archiveIndex.empty())
+        archiveStr.write((const char*) &archiveIndex[0],
+                archiveIndex.size() * sizeof(Index_Entry));
+
+    unsigned long long end = archiveStr.tellp();
+
+    archiveStr.seekp(start, ios::beg);
+    archiveStr.write((const char*) &header, sizeof(header));
+    archiveStr.seekp(end, ios::beg);
+
+    return archiveStr.fail() ? -1 : failed;
+}
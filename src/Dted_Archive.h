@@ -0,0 +1,132 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Single file archive of packed Dted cells (".dta").
+//               The archive starts with a header page, followed by the
+//               cells in the packed cell layout (see
+//               Dted_Packed_Format.h), each on a page boundary, and ends
+//               with an index of the cells sorted by (latitude,
+//               longitude).  The whole archive is opened with a single
+//               memory mapping which the cells created from it share.
+//
+//********************************************************************
+
+#ifndef Dted_Archive_H
+#define Dted_Archive_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Dted_Cell_Path_Entry.h"
+
+using namespace std;
+
+class Dted_Cell;
+
+class Dted_Archive {
+public:
+
+    struct Header {
+        enum {
+            VERSION = 1
+        };
+
+        //! "DTEDARCH"
+        char magic[8];
+        unsigned int version;
+        //! Dted_Packed_Header::BYTE_ORDER_MARK in the writer's byte order.
+        unsigned int byteOrder;
+        unsigned int cellCount;
+        unsigned int reserved;
+        unsigned long long indexOffset;
+    };
+
+    //! Location of one cell in the archive.
+    struct Index_Entry {
+        short latitude;
+        short longitude;
+        unsigned int reserved;
+        unsigned long long offset;
+        unsigned long long size;
+    };
+
+    Dted_Archive();
+
+    //! Unmaps the archive.
+    ~Dted_Archive();
+
+    //! Returns true if the file starts with the archive magic.
+    static bool Is_Archive(const string& path);
+
+    /*! Map an archive and validate its index.
+     @param path file holding the archive.
+     @param offset page aligned start of the archive within the file, for
+     archives embedded in another file.
+     @return Returns true on success, false on error.
+     */
+    bool Open(const string& path, unsigned long long offset = 0);
+
+    //! Path of the archive.
+    const string& Get_Path() const;
+
+    //! Number of cells in the archive.
+    int Get_Cell_Count() const;
+
+    //! Index entry of the i-th cell, in (latitude, longitude) order.
+    const Index_Entry& Get_Entry(int i) const;
+
+    //! Binary search of the index; NULL if the cell is not archived.
+    const Index_Entry* Find(short latitude, short longitude) const;
+
+    //! Start of a cell's packed cell image within the mapping.
+    const unsigned char* Get_Cell_Image(const Index_Entry& entry) const;
+
+    /*! Write an archive of the cells of a directory entry list.  The
+     cells may be Dted files or packed cells.
+     @param cellEntries cells to archive, in any order.
+     @param path archive to write; replaced atomically.
+     @return number of cells that failed to be archived, or -1 if the
+     archive could not be written.
+     */
+    static int Build(const vector<Dted_Cell_Path_Entry>& cellEntries,
+            const string& path);
+
+    /*! Write an archive to a stream from its current position, which
+     should be page aligned.  Offsets in the archive are relative to
+     that position.
+     @param cellEntries cells to archive, sorted and without duplicates.
+     @param cells for each entry, a resident cell to write, or NULL to
+     open the cell from the entry.
+     @return number of cells that failed to be archived, or -1 on a
+     stream error.
+     */
+    static int Write(const vector<Dted_Cell_Path_Entry>& cellEntries,
+            const vector<Dted_Cell*>& cells, ostream& archiveStr);
+
+private:
+
+    Dted_Archive(const Dted_Archive&);
+    const Dted_Archive& operator=(const Dted_Archive&);
+
+    void Close();
+
+    string archivePath;
+    unsigned char* mappedRegion;
+    size_t mappedSize;
+
+    //! Start and size of the archive within the mapping.
+    const unsigned char* archiveBase;
+    size_t archiveSize;
+
+    const Index_Entry* index;
+    int cellCount;
+};
+
+#endif
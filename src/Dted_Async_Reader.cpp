@@ -0,0 +1,402 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Performs a batch of file reads with many reads
+//               outstanding at once (io_uring or a pread() pool).
+//
+//********************************************************************
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Dted_Async_Reader.h"
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+
+//! Minimal io_uring binding over the raw system calls.
+struct Dted_Async_Reader::Ring {
+    int fd;
+
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe* sqes;
+    size_t sqesSize;
+
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned* sqArray;
+    unsigned sqEntries;
+
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe* cqes;
+};
+
+bool Dted_Async_Reader::Setup_Ring(unsigned int entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+
+    if (fd < 0)
+        return false;
+
+    Ring* newRing = new Ring();
+    memset(newRing, 0, sizeof(Ring));
+    newRing->fd = fd;
+
+    newRing->sqRingSize = params.sq_off.array
+            + params.sq_entries * sizeof(unsigned);
+    newRing->cqRingSize = params.cq_off.cqes
+            + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+    if (singleMmap) {
+        if (newRing->cqRingSize > newRing->sqRingSize)
+            newRing->sqRingSize = newRing->cqRingSize;
+        newRing->cqRingSize = newRing->sqRingSize;
+    }
+
+    newRing->sqRing = mmap(NULL, newRing->sqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+    if (newRing->sqRing == MAP_FAILED) {
+        ::close(fd);
+        delete newRing;
+        return false;
+    }
+
+    if (singleMmap) {
+        newRing->cqRing = newRing->sqRing;
+    } else {
+        newRing->cqRing = mmap(NULL, newRing->cqRingSize,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                IORING_OFF_CQ_RING);
+
+        if (newRing->cqRing == MAP_FAILED) {
+            munmap(newRing->sqRing, newRing->sqRingSize);
+            ::close(fd);
+            delete newRing;
+            return false;
+        }
+    }
+
+    newRing->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    newRing->sqes = (struct io_uring_sqe*) mmap(NULL, newRing->sqesSize,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+            IORING_OFF_SQES);
+
+    if (newRing->sqes == MAP_FAILED) {
+        if (!singleMmap)
+            munmap(newRing->cqRing, newRing->cqRingSize);
+        munmap(newRing->sqRing, newRing->sqRingSize);
+        ::close(fd);
+        delete newRing;
+        return false;
+    }
+
+    char* sq = (char*) newRing->sqRing;
+    newRing->sqHead = (unsigned*) (sq + params.sq_off.head);
+    newRing->sqTail = (unsigned*) (sq + params.sq_off.tail);
+    newRing->sqMask = *(unsigned*) (sq + params.sq_off.ring_mask);
+    newRing->sqArray = (unsigned*) (sq + params.sq_off.array);
+    newRing->sqEntries = params.sq_entries;
+
+    char* cq = (char*) newRing->cqRing;
+    newRing->cqHead = (unsigned*) (cq + params.cq_off.head);
+    newRing->cqTail = (unsigned*) (cq + params.cq_off.tail);
+    newRing->cqMask = *(unsigned*) (cq + params.cq_off.ring_mask);
+    newRing->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+    ring = newRing;
+
+    return true;
+}
+
+void Dted_Async_Reader::Teardown_Ring() {
+    if (ring == NULL)
+        return;
+
+    munmap(ring->sqes, ring->sqesSize);
+
+    if (ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+
+    munmap(ring->sqRing, ring->sqRingSize);
+    ::close(ring->fd);
+
+    delete ring;
+    ring = NULL;
+}
+
+void Dted_Async_Reader::Read_All_Uring(const vector<Read_Request>& requests,
+        const Completion& onComplete) {
+    // Progress of each read; short reads are resubmitted for the rest.
+    vector<size_t> done(requests.size(), 0);
+    vector<struct iovec> iovecs(requests.size());
+    deque<size_t> pending;
+
+    for (size_t i = 0; i < requests.size(); i++)
+        pending.push_back(i);
+
+    size_t inFlight = 0;
+    size_t remaining = requests.size();
+
+    // Set once io_uring_enter() fails for good; the reads in flight are
+    // then drained before the ring is torn down.
+    bool ringFailed = false;
+
+    while (remaining > 0) {
+        if (ringFailed) {
+            if (inFlight == 0)
+                break;
+
+            // The kernel may still write into the buffers of the reads
+            // in flight; wait for them before the fallback reuses them.
+            if ((syscall(__NR_io_uring_enter, ring->fd, 0, 1,
+                    IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+                    && (errno != EINTR) && (errno != EAGAIN)
+                    && (errno != EBUSY))
+                break;
+
+            Reap_Completions(requests, onComplete, done, pending, inFlight,
+                    remaining);
+            continue;
+        }
+
+        // Entries the kernel has not consumed yet (after a short or
+        // refused io_uring_enter) are still queued between head and tail
+        // and are submitted again with the new ones.
+        unsigned tail = *ring->sqTail;
+        unsigned queued = tail
+                - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+
+        while (!pending.empty() && (inFlight + queued < ring->sqEntries)) {
+            size_t i = pending.front();
+            pending.pop_front();
+
+            const Read_Request& request = requests[i];
+
+            iovecs[i].iov_base = request.buffer + done[i];
+            iovecs[i].iov_len = request.length - done[i];
+
+            unsigned slot = tail & ring->sqMask;
+            struct io_uring_sqe* sqe = &ring->sqes[slot];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = request.fd;
+            sqe->off = request.offset + done[i];
+            sqe->addr = (unsigned long) &iovecs[i];
+            sqe->len = 1;
+            sqe->user_data = i;
+
+            ring->sqArray[slot] = slot;
+            tail++;
+            queued++;
+        }
+
+        __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+
+        // Only wait when something is, or may become, in flight.
+        unsigned minComplete = ((inFlight + queued) > 0) ? 1 : 0;
+
+        int entered = (int) syscall(__NR_io_uring_enter, ring->fd, queued,
+                minComplete, IORING_ENTER_GETEVENTS, NULL, 0);
+
+        if (entered >= 0) {
+            // The kernel may consume fewer entries than offered.
+            inFlight += entered;
+        } else if ((errno == EAGAIN) || (errno == EBUSY)) {
+            // Out of resources or completions overflowing: nothing was
+            // submitted.  Wait for a read in flight to complete and free
+            // its resources, then offer the queued entries again.
+            if (inFlight > 0)
+                syscall(__NR_io_uring_enter, ring->fd, 0, 1,
+                        IORING_ENTER_GETEVENTS, NULL, 0);
+            else
+                boost::this_thread::yield();
+        } else if (errno != EINTR) {
+            // The ring is unusable; drain it, then finish with plain
+            // reads.
+            ringFailed = true;
+        }
+
+        Reap_Completions(requests, onComplete, done, pending, inFlight,
+                remaining);
+    }
+
+    if (ringFailed) {
+        Teardown_Ring();
+
+        // Redo every read not completed through the ring.
+        for (size_t i = 0; i < requests.size(); i++) {
+            if (done[i] != requests[i].length + 1)
+                onComplete(requests[i], Read_Fully(requests[i]));
+        }
+    }
+}
+
+void Dted_Async_Reader::Reap_Completions(const vector<Read_Request>& requests,
+        const Completion& onComplete, vector<size_t>& done,
+        deque<size_t>& pending, size_t& inFlight, size_t& remaining) {
+    unsigned head = *ring->cqHead;
+    unsigned cqTail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+    while (head != cqTail) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+        size_t i = (size_t) cqe->user_data;
+        int result = cqe->res;
+
+        head++;
+        inFlight--;
+
+        if ((result == -EINTR) || (result == -EAGAIN)) {
+            pending.push_back(i);
+        } else if ((result > 0)
+                && (done[i] + result < requests[i].length)) {
+            done[i] += result;
+            pending.push_back(i);
+        } else {
+            bool ok = (result > 0)
+                    || ((result == 0) && (requests[i].length == done[i]));
+
+            // Mark as completed (length + 1 never is a byte count).
+            done[i] = requests[i].length + 1;
+            remaining--;
+
+            onComplete(requests[i], ok);
+        }
+    }
+
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+}
+
+#else
+
+struct Dted_Async_Reader::Ring {
+};
+
+bool Dted_Async_Reader::Setup_Ring(unsigned int entries) {
+    return false;
+}
+
+void Dted_Async_Reader::Teardown_Ring() {
+}
+
+void Dted_Async_Reader::Read_All_Uring(const vector<Read_Request>& requests,
+        const Completion& onComplete) {
+    Read_All_Threads(requests, onComplete);
+}
+
+#endif
+
+Dted_Async_Reader::Dted_Async_Reader(unsigned int queueDepth, bool useUring) :
+        ring(NULL),
+        queueDepth(queueDepth) {
+    if (useUring)
+        Setup_Ring(queueDepth);
+}
+
+Dted_Async_Reader::~Dted_Async_Reader() {
+    Teardown_Ring();
+}
+
+bool Dted_Async_Reader::Is_Uring() const {
+    return ring != NULL;
+}
+
+void Dted_Async_Reader::Read_All(const vector<Read_Request>& requests,
+        const Completion& onComplete) {
+    if (requests.empty())
+        return;
+
+    if (ring != NULL)
+        Read_All_Uring(requests, onComplete);
+    else
+        Read_All_Threads(requests, onComplete);
+}
+
+bool Dted_Async_Reader::Read_Fully(const Read_Request& request) {
+    size_t done = 0;
+
+    while (done < request.length) {
+        ssize_t result = pread(request.fd, request.buffer + done,
+                request.length - done, request.offset + done);
+
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        if (result == 0)
+            return false;
+
+        done += result;
+    }
+
+    return true;
+}
+
+namespace {
+
+void Read_Worker(const vector<Dted_Async_Reader::Read_Request>* requests,
+        boost::atomic<size_t>* next,
+        const Dted_Async_Reader::Completion* onComplete,
+        bool (*readFully)(const Dted_Async_Reader::Read_Request&)) {
+    for (;;) {
+        size_t i = next->fetch_add(1);
+
+        if (i >= requests->size())
+            return;
+
+        (*onComplete)((*requests)[i], readFully((*requests)[i]));
+    }
+}
+
+}
+
+void Dted_Async_Reader::Read_All_Threads(const vector<Read_Request>& requests,
+        const Completion& onComplete) {
+    boost::atomic<size_t> next(0);
+    size_t threadCount = DEFAULT_FALLBACK_THREADS;
+
+    if (threadCount > requests.size())
+        threadCount = requests.size();
+
+    // The calling thread is one of the readers.
+    boost::thread_group threads;
+
+    for (size_t i = 1; i < threadCount; i++)
+        threads.create_thread(
+                boost::bind(&Read_Worker, &requests, &next, &onComplete,
+                        &Dted_Async_Reader::Read_Fully));
+
+    Read_Worker(&requests, &next, &onComplete, &Dted_Async_Reader::Read_Fully);
+
+    threads.join_all();
+}
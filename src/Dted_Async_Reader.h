@@ -0,0 +1,99 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Performs a batch of file reads with many reads
+//               outstanding at once.  On Linux the reads are submitted
+//               through io_uring; where io_uring is unavailable (older
+//               kernels, seccomp filtered containers, other platforms)
+//               a pool of threads issues pread() calls instead.  A
+//               completion callback runs as each read lands so that
+//               the caller can decode while other reads are in flight.
+//
+//********************************************************************
+
+#ifndef Dted_Async_Reader_H
+#define Dted_Async_Reader_H
+
+#include <sys/types.h>
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+
+using namespace std;
+
+class Dted_Async_Reader {
+public:
+
+    enum {
+        DEFAULT_QUEUE_DEPTH = 256, // Reads in flight with io_uring
+        DEFAULT_FALLBACK_THREADS = 8 // pread() threads without io_uring
+    };
+
+    //! One read of length bytes at offset of fd into buffer.
+    struct Read_Request {
+        int fd;
+        off_t offset;
+        size_t length;
+        unsigned char* buffer;
+        //! Caller's identifier of the read.
+        size_t index;
+    };
+
+    //! Called once per read.  With the thread fallback completions may
+    //! run concurrently on several threads.
+    typedef boost::function<void(const Read_Request&, bool ok)> Completion;
+
+    /*! Constructor.
+     @param queueDepth maximum reads in flight.
+     @param useUring try io_uring before falling back to threads.
+     */
+    Dted_Async_Reader(unsigned int queueDepth = DEFAULT_QUEUE_DEPTH,
+            bool useUring = true);
+
+    ~Dted_Async_Reader();
+
+    //! Returns true if reads go through io_uring.
+    bool Is_Uring() const;
+
+    //! Perform every read, calling onComplete as each one finishes.
+    //! Returns once all reads completed.
+    void Read_All(const vector<Read_Request>& requests,
+            const Completion& onComplete);
+
+private:
+
+    Dted_Async_Reader(const Dted_Async_Reader&);
+    const Dted_Async_Reader& operator=(const Dted_Async_Reader&);
+
+    struct Ring;
+
+    bool Setup_Ring(unsigned int entries);
+    void Teardown_Ring();
+
+    void Read_All_Uring(const vector<Read_Request>& requests,
+            const Completion& onComplete);
+    void Read_All_Threads(const vector<Read_Request>& requests,
+            const Completion& onComplete);
+
+    //! Consume the io_uring completions that have arrived: finish the
+    //! completed reads and queue the short or interrupted ones again.
+    void Reap_Completions(const vector<Read_Request>& requests,
+            const Completion& onComplete, vector<size_t>& done,
+            deque<size_t>& pending, size_t& inFlight, size_t& remaining);
+
+    //! Blocking read of a whole request, retrying short reads.
+    static bool Read_Fully(const Read_Request& request);
+
+    Ring* ring;
+    unsigned int queueDepth;
+};
+
+#endif
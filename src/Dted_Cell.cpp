@@ -16,8 +16,12 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include "Dted_Archive.h"
 #include "Dted_Cell.h"
+#include "Dted_Packed_Format.h"
 #include "Dted_Vol.h"
 #include "Dted_Hdr.h"
 #include "Dted_Uhl.h"
@@ -25,6 +29,7 @@
 #include "Dted_Acc.h"
 #include "Dted_Record.h"
 #include "Endian.h"
+#include <algorithm>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -42,7 +47,26 @@ Dted_Cell::Dted_Cell(const string& dted_file)
       theLatSpacing(0.0),
       theLonSpacing(0.0),
       theSwCornerPost(),
-      byteSwap(false)
+      theNullHeightValue(0.0),
+      bilinearInterpActive(false),
+      byteSwap(false),
+      dtedPostMemPtr(NULL),
+      thePacked(false),
+      theMappedRegion(NULL),
+      theMappedSize(0),
+      theCompressedPosts(NULL),
+      theUniform(false),
+      theUniformValue(0),
+      theTileArena(NULL),
+      theArenaPosts(false),
+      thePageCache(NULL),
+      thePageSlots(NULL),
+      theAccessCount(0),
+      thePinned(false),
+      theLockedPosts(false),
+      theOverview(NULL),
+      theMinMaxTree(NULL),
+      debug(false)
 {
     Endian endianObj;
 
@@ -57,6 +81,20 @@ Dted_Cell::Dted_Cell(const string& dted_file)
         return;
     }
 
+    char magic[sizeof(((Dted_Packed_Header*) 0)->magic)];
+    theFileStr.read(magic, sizeof(magic));
+    bool packed = (theFileStr.gcount() == (streamsize) sizeof(magic))
+            && Dted_Packed_Header::Has_Magic(magic);
+    theFileStr.clear();
+    theFileStr.seekg(0, ios::beg);
+
+    if (packed) {
+        if (!openPacked())
+            cerr << "ERROR: Invalid packed dted cell:  " << dted_file.c_str()
+                    << std::endl;
+        return;
+    }
+
     // DTED is stored in big endian.
     byteSwap =
             endianObj.getSystemEndianType() == ARCH_LITTLE_ENDIAN ?
@@ -85,11 +123,52 @@ Dted_Cell::Dted_Cell(const string& dted_file)
 
     theSwCornerPost.lat = uhl.latOrigin();
     theSwCornerPost.lon = uhl.lonOrigin();
+}
 
-    theNullHeightValue = 0.0;
+Dted_Cell::Dted_Cell(const boost::shared_ptr<Dted_Archive>& archive,
+        short latitude, short longitude)
+   :
+      theFileStr(),
+      theNumLonLines(0),
+      theNumLatPoints(0),
+      theDtedRecordSizeInBytes(0),
+      theEdition(),
+      theProductLevel(),
+      theCompilationDate(),
+      theOffsetToFirstDataRecord(0),
+      theLatSpacing(0.0),
+      theLonSpacing(0.0),
+      theSwCornerPost(),
+      theNullHeightValue(0.0),
+      bilinearInterpActive(false),
+      byteSwap(false),
+      theFilename(archive->Get_Path()),
+      dtedPostMemPtr(NULL),
+      thePacked(false),
+      theMappedRegion(NULL),
+      theMappedSize(0),
+      theArchive(archive),
+      theCompressedPosts(NULL),
+      theUniform(false),
+      theUniformValue(0),
+      theTileArena(NULL),
+      theArenaPosts(false),
+      thePageCache(NULL),
+      thePageSlots(NULL),
+      theAccessCount(0),
+      thePinned(false),
+      theLockedPosts(false),
+      theOverview(NULL),
+      theMinMaxTree(NULL),
+      debug(false)
+{
+    const Dted_Archive::Index_Entry* entry = archive->Find(latitude,
+            longitude);
 
-    dtedPostMemPtr = NULL;
-    debug = false;
+    if ((entry == NULL)
+            || !attachPacked(archive->Get_Cell_Image(*entry), entry->size))
+        cerr << "ERROR: Invalid archived dted cell (" << latitude << ", "
+                << longitude << ") in:  " << theFilename.c_str() << std::endl;
 }
 
 bool Dted_Cell::covers(Geo_Location targetLoc) {
@@ -115,35 +194,495 @@ bool Dted_Cell::covers(Geo_Location targetLoc) {
         return false;
 }
 
+bool Dted_Cell::openPacked() {
+    int fd = ::open(theFilename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* region = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (region == MAP_FAILED)
+        return false;
+
+    if (!attachPacked((const unsigned char*) region, fileStat.st_size)) {
+        munmap(region, fileStat.st_size);
+        return false;
+    }
+
+    theMappedRegion = region;
+    theMappedSize = fileStat.st_size;
+
+    // Everything is mapped; the stream is no longer needed.
+    theFileStr.close();
+
+    return true;
+}
+
+bool Dted_Cell::attachPacked(const unsigned char* packedImage,
+        size_t imageSize) {
+    Dted_Packed_Header header;
+
+    if (imageSize < sizeof(header))
+        return false;
+
+    memcpy(&header, packedImage, sizeof(header));
+
+    if (!Dted_Packed_Header::Has_Magic(header.magic)
+            || (header.version != Dted_Packed_Header::VERSION)
+            || (header.byteOrder != Dted_Packed_Header::BYTE_ORDER_MARK)
+            || (header.numLonLines < 2) || (header.numLatPoints < 2)
+            || ((header.postsSize
+                    != (unsigned long long) header.numLonLines
+                            * header.numLatPoints * POST_SIZE)
+                    && !(header.flags & Dted_Packed_Header::UNIFORM))
+            || (header.postsOffset > imageSize)
+            || (header.postsSize > imageSize - header.postsOffset))
+        return false;
+
+    thePacked = true;
+
+    theNumLonLines = header.numLonLines;
+    theNumLatPoints = header.numLatPoints;
+    theLatSpacing = header.latSpacing;
+    theLonSpacing = header.lonSpacing;
+    theSwCornerPost.lat = header.swCornerLat;
+    theSwCornerPost.lon = header.swCornerLon;
+    theMinHeightAboveMSL = header.minHeightAboveMSL;
+    theMaxHeightAboveMSL = header.maxHeightAboveMSL;
+
+    theEdition.assign(header.edition,
+            strnlen(header.edition, sizeof(header.edition)));
+    theProductLevel.assign(header.productLevel,
+            strnlen(header.productLevel, sizeof(header.productLevel)));
+    theCompilationDate.assign(header.compilationDate,
+            strnlen(header.compilationDate, sizeof(header.compilationDate)));
+
+    if (header.flags & Dted_Packed_Header::UNIFORM) {
+        theUniform = true;
+        theUniformValue = header.uniformValue;
+    } else {
+        dtedPostMemPtr = (short*) (packedImage + header.postsOffset);
+    }
+
+    return true;
+}
+
+bool Dted_Cell::isPacked() const {
+    return thePacked;
+}
+
+bool Dted_Cell::isResident() const {
+    return theUniform || (dtedPostMemPtr != NULL)
+            || (theCompressedPosts != NULL);
+}
+
+bool Dted_Cell::isCompressed() const {
+    return theCompressedPosts != NULL;
+}
+
+bool Dted_Cell::pinPosts(bool lockMemory) {
+    boost::mutex::scoped_lock lock(sharedMutex);
+
+    if (!hasDirectPosts())
+        return false;
+
+    thePinned = true;
+
+    if (theUniform)
+        return true;
+
+    size_t size = (size_t) theNumLonLines * theNumLatPoints * POST_SIZE;
+
+    // Touch every page so no query takes a page fault.
+    const volatile char* posts = (const volatile char*) dtedPostMemPtr;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+
+    for (size_t offset = 0; offset < size; offset += pageSize)
+        (void) posts[offset];
+
+    if (!lockMemory || theLockedPosts)
+        return true;
+
+    if (mlock(dtedPostMemPtr, size) != 0)
+        return false;
+
+    theLockedPosts = true;
+
+    return true;
+}
+
+bool Dted_Cell::isPinned() const {
+    return thePinned;
+}
+
+bool Dted_Cell::compressPosts() {
+    boost::mutex::scoped_lock lock(sharedMutex);
+
+    // Mapped posts stay in the page cache; only heap posts are worth it.
+    if (thePacked || theUniform || (dtedPostMemPtr == NULL))
+        return false;
+
+    theCompressedPosts = new Dted_Compressed_Posts(dtedPostMemPtr,
+            theNumLonLines, theNumLatPoints);
+
+    releasePosts();
+
+    return true;
+}
+
+size_t Dted_Cell::getResidentSize() const {
+    boost::mutex::scoped_lock lock(sharedMutex);
+
+    if (theCompressedPosts != NULL)
+        return theCompressedPosts->Get_Compressed_Size();
+
+    if ((dtedPostMemPtr != NULL) && !thePacked)
+        return (size_t) theNumLonLines * theNumLatPoints * POST_SIZE;
+
+    return 0;
+}
+
+unsigned int Dted_Cell::getAccessCount() const {
+    return theAccessCount.load(boost::memory_order_relaxed);
+}
+
+void Dted_Cell::setAccessCount(unsigned int accessCount) {
+    theAccessCount.store(accessCount, boost::memory_order_relaxed);
+}
+
+Geo_Location Dted_Cell::getSwCornerPost() const {
+    return theSwCornerPost;
+}
+
+bool Dted_Cell::writePacked(const string& packedFile) {
+    // Write aside and rename so readers never map a partial file.
+    string tempFile = packedFile + ".tmp";
+    ofstream packedStr(tempFile.c_str(), ios::out | ios::binary | ios::trunc);
+
+    if (!packedStr.is_open())
+        return false;
+
+    bool written = writePacked(packedStr);
+    packedStr.close();
+
+    if (!written || packedStr.fail()
+            || (rename(tempFile.c_str(), packedFile.c_str()) != 0)) {
+        unlink(tempFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool Dted_Cell::writePacked(ostream& packedStr) {
+    if (!isResident())
+        loadCellFromDisk();
+
+    if (!isResident())
+        return false;
+
+    size_t numPosts = (size_t) theNumLonLines * theNumLatPoints;
+    const short* posts = dtedPostMemPtr;
+    vector<short> decodedPosts;
+
+    if (theCompressedPosts != NULL) {
+        decodedPosts.resize(numPosts);
+        theCompressedPosts->Decode_All(&decodedPosts[0]);
+        posts = &decodedPosts[0];
+    }
+
+    // A uniform cell is written as its header alone.
+    if (theUniform)
+        numPosts = 0;
+
+    Dted_Packed_Header header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, "DTEDPACK", sizeof(header.magic));
+    header.version = Dted_Packed_Header::VERSION;
+    header.byteOrder = Dted_Packed_Header::BYTE_ORDER_MARK;
+    header.numLonLines = theNumLonLines;
+    header.numLatPoints = theNumLatPoints;
+    header.latSpacing = theLatSpacing;
+    header.lonSpacing = theLonSpacing;
+    header.swCornerLat = theSwCornerPost.lat;
+    header.swCornerLon = theSwCornerPost.lon;
+    header.postsOffset = Dted_Packed_Header::PAGE_SIZE;
+    header.postsSize = numPosts * POST_SIZE;
+
+    if (theUniform) {
+        header.flags = Dted_Packed_Header::UNIFORM;
+        header.uniformValue = theUniformValue;
+    }
+
+    strncpy(header.edition, theEdition.c_str(), sizeof(header.edition));
+    strncpy(header.productLevel, theProductLevel.c_str(),
+            sizeof(header.productLevel));
+    strncpy(header.compilationDate, theCompilationDate.c_str(),
+            sizeof(header.compilationDate));
+
+    header.minHeightAboveMSL = 32767;
+    header.maxHeightAboveMSL = -32767;
+
+    if (theUniform) {
+        if (theUniformValue != NULL_POST)
+            header.minHeightAboveMSL = theUniformValue;
+        header.maxHeightAboveMSL = theUniformValue;
+    }
+
+    for (size_t i = 0; i < numPosts; i++) {
+        short post = posts[i];
+
+        if ((post < header.minHeightAboveMSL) && (post != NULL_POST))
+            header.minHeightAboveMSL = post;
+        if (post > header.maxHeightAboveMSL)
+            header.maxHeightAboveMSL = post;
+    }
+
+    char page[Dted_Packed_Header::PAGE_SIZE];
+    memset(page, 0, sizeof(page));
+    memcpy(page, &header, sizeof(header));
+
+    packedStr.write(page, sizeof(page));
+    packedStr.write((const char*) posts, header.postsSize);
+
+    return packedStr.good();
+}
+
 void Dted_Cell::loadCellFromDisk() {
+    unsigned char* dataRegion;
+    size_t dataRegionSize = getDataRegionSize();
+
+    // Packed cells are mapped; a cell which failed to open has no posts.
+    if (thePacked || theUniform || (theCompressedPosts != NULL)
+            || (dataRegionSize == 0))
+        return;
+
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+
+        dataRegion = (unsigned char *) malloc(dataRegionSize);
+
+        memset(dataRegion, 0, dataRegionSize);
+
+        // Read all records at once rather than seeking record by record.
+        theFileStr.seekg(theOffsetToFirstDataRecord, ios::beg);
+        theFileStr.read((char*) dataRegion, dataRegionSize);
+    }
+
+    adoptDataRegion(dataRegion);
+}
+
+long Dted_Cell::getDataRegionOffset() const {
+    return theOffsetToFirstDataRecord;
+}
+
+size_t Dted_Cell::getDataRegionSize() const {
+    if (thePacked)
+        return 0;
+
+    return (size_t) theNumLonLines * theDtedRecordSizeInBytes;
+}
+
+void Dted_Cell::adoptDataRegion(unsigned char* dataRegion) {
     boost::mutex::scoped_lock lock(sharedMutex);
 
-    int offset;
+    if (thePacked || theUniform || (theCompressedPosts != NULL)) {
+        free(dataRegion);
+        return;
+    }
+
+    size_t numPosts = (size_t) theNumLonLines * theNumLatPoints;
 
-    dtedPostMemPtr = (unsigned char *) malloc(
-            (theNumLonLines * theNumLatPoints) * POST_SIZE);
+    releasePosts();
 
-    memset(dtedPostMemPtr, 0, (theNumLonLines * theNumLatPoints) * POST_SIZE);
+    // Decode straight into the arena, or else in place.
+    short* posts = NULL;
 
-    theFileStr.seekg(theOffsetToFirstDataRecord, ios::beg);
+    if (theTileArena != NULL)
+        posts = (short*) theTileArena->Allocate(numPosts * POST_SIZE);
+
+    theArenaPosts = (posts != NULL);
+
+    posts = decodeRecords(dataRegion, theNumLonLines, posts);
+
+    // Ocean and void cells are a single value; keep only that.
+    size_t n = 1;
+
+    while ((n < numPosts) && (posts[n] == posts[0]))
+        n++;
+
+    if (n == numPosts) {
+        theUniform = true;
+        theUniformValue = posts[0];
+
+        if (theArenaPosts)
+            theTileArena->Free(posts, numPosts * POST_SIZE);
+
+        theArenaPosts = false;
+        free(dataRegion);
+        return;
+    }
+
+    if (theArenaPosts) {
+        free(dataRegion);
+        dtedPostMemPtr = posts;
+        return;
+    }
+
+    short* shrunk = (short*) realloc(dataRegion, numPosts * POST_SIZE);
+
+    dtedPostMemPtr = (shrunk != NULL) ? shrunk : posts;
+}
+
+void Dted_Cell::setTileArena(Dted_Tile_Arena* tileArena) {
+    theTileArena = tileArena;
+}
+
+void Dted_Cell::releasePosts() {
+    if (thePacked || (dtedPostMemPtr == NULL))
+        return;
+
+    if (theArenaPosts)
+        theTileArena->Free(dtedPostMemPtr,
+                (size_t) theNumLonLines * theNumLatPoints * POST_SIZE);
+    else
+        free(dtedPostMemPtr);
+
+    dtedPostMemPtr = NULL;
+    theArenaPosts = false;
+}
+
+short* Dted_Cell::decodeRecords(unsigned char* records, int numLines,
+        short* posts) {
+    // In place, the posts of record i move down to i * theNumLatPoints,
+    // which never overtakes the record still to be read.
+    if (posts == NULL)
+        posts = (short*) records;
+
+    for (int i = 0; i < numLines; i++) {
+        unsigned char* record = records + (size_t) i * theDtedRecordSizeInBytes
+                + DATA_RECORD_OFFSET_TO_POST;
+        short* line = posts + (size_t) i * theNumLatPoints;
+
+        memmove(line, record, theNumLatPoints * POST_SIZE);
+
+        for (int j = 0; j < theNumLatPoints; j++) {
+            unsigned short us = (unsigned short) line[j];
+            line[j] = convertSignedMagnitude(us);
+        }
+    }
+
+    return posts;
+}
+
+void Dted_Cell::setPageCache(Dted_Page_Cache* pageCache) {
+    if (thePacked || isResident() || (thePageSlots != NULL)
+            || (getDataRegionSize() == 0))
+        return;
+
+    int numPages = (theNumLonLines + Dted_Page_Cache::PAGE_LINES - 1)
+            / Dted_Page_Cache::PAGE_LINES;
+
+    thePageCache = pageCache;
+    thePageSlots = new Dted_Page_Cache::Page_Slot[numPages];
+}
+
+bool Dted_Cell::isPaged() const {
+    return thePageSlots != NULL;
+}
+
+short Dted_Cell::pagedPost(int x, int y) const {
+    Dted_Page_Cache::Page_Slot& slot = thePageSlots[x
+            / Dted_Page_Cache::PAGE_LINES];
+    const short* posts = slot.posts.load(boost::memory_order_acquire);
+
+    if (posts == NULL) {
+        posts = thePageCache->Load_Page(const_cast<Dted_Cell*>(this),
+                x / Dted_Page_Cache::PAGE_LINES);
+
+        if (posts == NULL)
+            return NULL_POST;
+    } else if (!slot.referenced.load(boost::memory_order_relaxed)) {
+        slot.referenced.store(true, boost::memory_order_relaxed);
+    }
+
+    return posts[(x % Dted_Page_Cache::PAGE_LINES) * theNumLatPoints + y];
+}
+
+Dted_Page_Cache::Page_Slot* Dted_Cell::pageSlot(int page) const {
+    return &thePageSlots[page];
+}
 
-    for (int i = 0; i < theNumLonLines; i++) {
-        theFileStr.seekg(DATA_RECORD_OFFSET_TO_POST, ios::cur); // 8 bytes
+short* Dted_Cell::readPage(int page, size_t& size) {
+    int firstLine = page * Dted_Page_Cache::PAGE_LINES;
+    int numLines = min((int) Dted_Page_Cache::PAGE_LINES,
+            theNumLonLines - firstLine);
+    size_t recordsSize = (size_t) numLines * theDtedRecordSizeInBytes;
 
-        offset = i * (theNumLatPoints * POST_SIZE);
+    unsigned char* records = (unsigned char*) malloc(recordsSize);
 
-        theFileStr.read((char*) &dtedPostMemPtr[offset],
-                (theNumLatPoints * POST_SIZE));
+    if (records == NULL)
+        return NULL;
 
-        theFileStr.seekg(DATA_RECORD_CHECKSUM_SIZE, ios::cur);  // 4 bytes
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+
+        theFileStr.clear();
+        theFileStr.seekg(theOffsetToFirstDataRecord
+                + (streamoff) firstLine * theDtedRecordSizeInBytes, ios::beg);
+        theFileStr.read((char*) records, recordsSize);
+
+        if (theFileStr.gcount() != (streamsize) recordsSize) {
+            theFileStr.clear();
+            free(records);
+            return NULL;
+        }
     }
+
+    short* posts = decodeRecords(records, numLines, NULL);
+
+    size = (size_t) numLines * theNumLatPoints * POST_SIZE;
+
+    short* shrunk = (short*) realloc(posts, size);
+
+    return (shrunk != NULL) ? shrunk : posts;
+}
+
+bool Dted_Cell::isUniform() const {
+    return theUniform;
 }
 
 Dted_Cell::~Dted_Cell() {
     close();
 
-    if (dtedPostMemPtr != NULL)
-        free(dtedPostMemPtr);
+    if (theLockedPosts)
+        munlock(dtedPostMemPtr,
+                (size_t) theNumLonLines * theNumLatPoints * POST_SIZE);
+
+    // Packed posts belong to the file mapping or to the archive.
+    if (theMappedRegion != NULL)
+        munmap(theMappedRegion, theMappedSize);
+    else
+        releasePosts();
+
+    delete theCompressedPosts;
+    delete theOverview.load();
+    delete theMinMaxTree.load();
+
+    if (thePageCache != NULL)
+        thePageCache->Release_Cell(this);
+
+    delete[] thePageSlots;
 }
 
 bool Dted_Cell::open() {
@@ -171,6 +710,12 @@ void Dted_Cell::setBilinearInterpActive(bool newState) {
 }
 
 double Dted_Cell::getHeightAboveMSL(const Geo_Location& gpt) {
+    return getHeightAboveMSL(gpt,
+            bilinearInterpActive ? BILINEAR : NEAREST_NEIGHBOR);
+}
+
+double Dted_Cell::getHeightAboveMSL(const Geo_Location& gpt,
+        Interpolation_Mode interpolation) const {
     // Establish the grid indexes
     double xi = fabs(gpt.lon - theSwCornerPost.lon) * (theNumLonLines - 1);
     double yi = fabs(gpt.lat - theSwCornerPost.lat) * (theNumLatPoints - 1);
@@ -184,63 +729,267 @@ double Dted_Cell::getHeightAboveMSL(const Geo_Location& gpt) {
         return theNullHeightValue;
     }
 
-    //***
-    // Grab the four points from the dted cell needed.  These are big endian,
-    // signed magnitude shorts so they must be interpreted accordingly.
-    //***
+    // Grab the four points from the dted cell needed.  The posts were
+    // converted to native shorts when the cell was loaded.
+    double p00 = residentPost(x0, y0); // Post 1 (Bottom left, where X(lon) & Y(lat))
 
-    int offset = (int) ((x0 * theNumLatPoints * POST_SIZE) + (y0 * POST_SIZE));
+    if (interpolation != BILINEAR)
+        return p00;
 
-    unsigned short us;
-    signed short ss;
-    double p00;   // Post 1 (Bottom left, where X(lon) & Y(lat))
-    double p01;   // Post 2 (Top left)
-    double p10;   // Post 3 (Bottom right)
-    double p11;   // Post 4 (Top right)
+    double p01 = residentPost(x0, y0 + 1); // Post 2 (Top left)
+    double p10 = residentPost(x0 + 1, y0); // Post 3 (Bottom right)
+    double p11 = residentPost(x0 + 1, y0 + 1); // Post 4 (Top right)
 
-    // Get the first post.
+    double interPolatedElev = bilinearInterpolate(xi, yi, p00, p01, p10, p11);
 
-    memcpy(&us, &dtedPostMemPtr[offset], sizeof(unsigned short));
-    ss = convertSignedMagnitude(us);
-    p00 = ss;
+    return interPolatedElev;
 
-    if (!bilinearInterpActive)
-        return p00;
+}
 
-    // Get the second post (i.e. below post #1 due to longitude)
-    offset += POST_SIZE;
-    memcpy(&us, &dtedPostMemPtr[offset], sizeof(unsigned short));
-    ss = convertSignedMagnitude(us);
-    p01 = ss;
+bool Dted_Cell::readOverviewHeight(const Geo_Location& gpt, int level,
+        Overview_Mode mode, Interpolation_Mode interpolation,
+        double& value) const {
+    const Dted_Overview* overview = getOverview();
+
+    if ((overview == NULL) || (level < 1)
+            || (level > overview->Get_Level_Count())
+            || !overview->Has_Mode(mode))
+        return false;
+
+    double xi = fabs(gpt.lon - theSwCornerPost.lon) * (theNumLonLines - 1);
+    double yi = fabs(gpt.lat - theSwCornerPost.lat) * (theNumLatPoints - 1);
+
+    if ((gpt.lon < theSwCornerPost.lon) || (gpt.lat < theSwCornerPost.lat)
+            || (xi >= theNumLonLines - 1) || (yi >= theNumLatPoints - 1))
+        return false;
+
+    int factor = 1 << level;
+    int numLonLines = overview->Get_Lon_Lines(level);
+    int numLatPoints = overview->Get_Lat_Points(level);
 
-    // Get the third post (i.e. on the right of post #1, therefore have to
-    // offset back 1 post size to lign-up on the right of post #1).
-    offset += (theNumLonLines * POST_SIZE) - POST_SIZE;
+    if (interpolation != BILINEAR) {
+        int x = min((int) floor(xi / factor + 0.5), numLonLines - 1);
+        int y = min((int) floor(yi / factor + 0.5), numLatPoints - 1);
 
-    // The following 'if' should never be true but need the check
-    // to avoid accessing out-of-bound memory
-    if (yi > (double) (theNumLatPoints - 1)) {
-        yi = (int) yi;
+        value = overview->Get_Post(level, mode, x, y);
+
+        return true;
     }
 
-    memcpy(&us, &dtedPostMemPtr[offset], sizeof(unsigned short));
-    ss = convertSignedMagnitude(us);
-    p10 = ss;
+    int x0 = min((int) (xi / factor), numLonLines - 2);
+    int y0 = min((int) (yi / factor), numLatPoints - 2);
 
-    // Get the fourth post (i.e. below post #3).
-    offset += POST_SIZE;
+    // The last overview line or point may be closer than factor posts.
+    double wx = (xi - x0 * factor)
+            / (min((x0 + 1) * factor, theNumLonLines - 1) - x0 * factor);
+    double wy = (yi - y0 * factor)
+            / (min((y0 + 1) * factor, theNumLatPoints - 1) - y0 * factor);
 
-    memcpy(&us, &dtedPostMemPtr[offset], sizeof(unsigned short));
-    ss = convertSignedMagnitude(us);
-    p11 = ss;
+    value = bilinearInterpolate(x0 + wx, y0 + wy,
+            overview->Get_Post(level, mode, x0, y0),
+            overview->Get_Post(level, mode, x0, y0 + 1),
+            overview->Get_Post(level, mode, x0 + 1, y0),
+            overview->Get_Post(level, mode, x0 + 1, y0 + 1));
 
-    double interPolatedElev = bilinearInterpolate(xi, yi, p00, p01, p10, p11);
+    return true;
+}
 
-    return interPolatedElev;
+const Dted_Overview* Dted_Cell::buildOverview(int levels,
+        unsigned int modes) {
+    Dted_Overview* overview = theOverview.load(boost::memory_order_acquire);
+
+    if ((overview != NULL) || theUniform || (levels <= 0))
+        return overview;
+
+    const short* posts = dtedPostMemPtr;
+    short* decodedPosts = NULL;
+
+    if (posts == NULL) {
+        posts = decodedPosts = decodeAllPosts();
+
+        if (posts == NULL)
+            return NULL;
+    }
 
+    overview = new Dted_Overview(posts, theNumLonLines, theNumLatPoints,
+            levels, modes);
+
+    free(decodedPosts);
+
+    // Another thread may have built them meanwhile.
+    Dted_Overview* expected = NULL;
+
+    if (!theOverview.compare_exchange_strong(expected, overview,
+            boost::memory_order_acq_rel)) {
+        delete overview;
+        overview = expected;
+    }
+
+    return overview;
+}
+
+const Dted_Min_Max_Tree* Dted_Cell::buildMinMaxTree() {
+    Dted_Min_Max_Tree* minMaxTree = theMinMaxTree.load(
+            boost::memory_order_acquire);
+
+    if ((minMaxTree != NULL) || theUniform)
+        return minMaxTree;
+
+    const short* posts = dtedPostMemPtr;
+    short* decodedPosts = NULL;
+
+    if (posts == NULL) {
+        posts = decodedPosts = decodeAllPosts();
+
+        if (posts == NULL)
+            return NULL;
+    }
+
+    minMaxTree = new Dted_Min_Max_Tree(posts, theNumLonLines,
+            theNumLatPoints);
+
+    free(decodedPosts);
+
+    Dted_Min_Max_Tree* expected = NULL;
+
+    if (!theMinMaxTree.compare_exchange_strong(expected, minMaxTree,
+            boost::memory_order_acq_rel)) {
+        delete minMaxTree;
+        minMaxTree = expected;
+    }
+
+    return minMaxTree;
+}
+
+bool Dted_Cell::findRegionPost(const Dted_Min_Max_Tree::Post_Range& range,
+        bool findMax, short& best) const {
+    Dted_Min_Max_Tree::Post_Range cellRange;
+    cellRange.x0 = max(range.x0, 0);
+    cellRange.x1 = min(range.x1, theNumLonLines - 1);
+    cellRange.y0 = max(range.y0, 0);
+    cellRange.y1 = min(range.y1, theNumLatPoints - 1);
+
+    if ((cellRange.x0 > cellRange.x1) || (cellRange.y0 > cellRange.y1))
+        return false;
+
+    if (theUniform) {
+        best = theUniformValue;
+        return theUniformValue != NULL_POST;
+    }
+
+    Region_Posts posts;
+    posts.cell = this;
+
+    const Dted_Min_Max_Tree* minMaxTree = getMinMaxTree();
+
+    if (minMaxTree != NULL)
+        return minMaxTree->Find(posts, cellRange, findMax, best);
+
+    bool found = false;
+    vector<short> line(cellRange.y1 - cellRange.y0 + 1);
+
+    for (int x = cellRange.x0; x <= cellRange.x1; x++) {
+        posts(x, cellRange.y0, cellRange.y1, &line[0]);
+
+        for (int y = 0; y <= cellRange.y1 - cellRange.y0; y++) {
+            short post = line[y];
+
+            if ((post != NULL_POST)
+                    && (!found || (findMax ? (post > best) : (post < best)))) {
+                best = post;
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+short* Dted_Cell::decodeAllPosts() {
+    if (theCompressedPosts != NULL) {
+        short* posts = (short*) malloc(
+                (size_t) theNumLonLines * theNumLatPoints * POST_SIZE);
+
+        if (posts != NULL)
+            theCompressedPosts->Decode_All(posts);
+
+        return posts;
+    }
+
+    size_t dataRegionSize = getDataRegionSize();
+
+    if (dataRegionSize == 0)
+        return NULL;
+
+    unsigned char* dataRegion = (unsigned char*) malloc(dataRegionSize);
+
+    if (dataRegion == NULL)
+        return NULL;
+
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+
+        theFileStr.clear();
+        theFileStr.seekg(theOffsetToFirstDataRecord, ios::beg);
+        theFileStr.read((char*) dataRegion, dataRegionSize);
+
+        if (theFileStr.gcount() != (streamsize) dataRegionSize) {
+            theFileStr.clear();
+            free(dataRegion);
+            return NULL;
+        }
+    }
+
+    return decodeRecords(dataRegion, theNumLonLines, NULL);
+}
+
+void Dted_Cell::regionPosts(int x, int y0, int y1, short* posts) const {
+    int count = y1 - y0 + 1;
+
+    if (hasDirectPosts() || (theCompressedPosts != NULL)
+            || (thePageSlots != NULL)) {
+        for (int y = 0; y < count; y++)
+            posts[y] = residentPost(x, y0 + y);
+
+        return;
+    }
+
+    // The posts of a longitude line are contiguous in its record.
+    unsigned short* raw = (unsigned short*) posts;
+
+    {
+        boost::mutex::scoped_lock lock(sharedMutex);
+
+        theFileStr.clear();
+        theFileStr.seekg(theOffsetToFirstDataRecord
+                + (streamoff) x * theDtedRecordSizeInBytes
+                + DATA_RECORD_OFFSET_TO_POST + y0 * POST_SIZE, ios::beg);
+
+        if (!theFileStr.read((char*) raw, (streamsize) count * POST_SIZE)) {
+            theFileStr.clear();
+
+            for (int y = 0; y < count; y++)
+                posts[y] = NULL_POST;
+
+            return;
+        }
+    }
+
+    for (int y = 0; y < count; y++)
+        posts[y] = convertSignedMagnitude(raw[y]);
 }
 
 double Dted_Cell::getHeightAboveMSLFromDisk(const Geo_Location& gpt) {
+    return getHeightAboveMSLFromDisk(gpt,
+            bilinearInterpActive ? BILINEAR : NEAREST_NEIGHBOR);
+}
+
+double Dted_Cell::getHeightAboveMSLFromDisk(const Geo_Location& gpt,
+        Interpolation_Mode interpolation) const {
+    // A packed cell's posts are mapped rather than read.
+    if (thePacked || (thePageSlots != NULL))
+        return getHeightAboveMSL(gpt, interpolation);
+
     boost::mutex::scoped_lock lock(sharedMutex);
 
     double xi = fabs(gpt.lon - theSwCornerPost.lon) * (theNumLonLines - 1);
@@ -278,7 +1027,7 @@ double Dted_Cell::getHeightAboveMSLFromDisk(const Geo_Location& gpt) {
     ss = convertSignedMagnitude(us);
     p00 = ss;
 
-    if (!bilinearInterpActive)
+    if (interpolation != BILINEAR)
         return p00;
 
     // Get Post 2.
@@ -287,7 +1036,7 @@ double Dted_Cell::getHeightAboveMSLFromDisk(const Geo_Location& gpt) {
     p01 = ss;
 
     // Get Post 3.
-    offset += theDtedRecordSizeInBytes - POST_SIZE;
+    offset += theDtedRecordSizeInBytes;
     theFileStr.seekg(offset, ios::beg);
 
     if (!theFileStr.eof()) {
@@ -312,7 +1061,7 @@ double Dted_Cell::getHeightAboveMSLFromDisk(const Geo_Location& gpt) {
 }
 
 double Dted_Cell::bilinearInterpolate(double xi, double yi, double p00,
-        double p01, double p10, double p11) {
+        double p01, double p10, double p11) const {
     // p00   // Post 1 (Bottom left, where X(lon) & Y(lat))
     // p01   // Post 2 (Top left)
     // p10   // Post 3 (Bottom right)
@@ -364,25 +1113,33 @@ double Dted_Cell::bilinearInterpolate(double xi, double yi, double p00,
 }
 
 double Dted_Cell::getPostValue(const Voxel& gridPt) {
+    double value;
 
-    // Do some error checking.
-    if (gridPt.x < 0.0 || gridPt.y < 0.0 || gridPt.x > (theNumLonLines - 1)
-            || gridPt.y > (theNumLatPoints - 1)) {
+    if (!readPostValue(gridPt, value)) {
         cerr << "WARNING : No intersection..." << std::endl;
         return theNullHeightValue;
     }
 
-    int offset = (int) (gridPt.x * (theNumLatPoints * POST_SIZE)
-            + gridPt.y * POST_SIZE);
+    return value;
+}
 
-    unsigned short us;
-    memcpy(&us, &dtedPostMemPtr[offset], sizeof(unsigned short));
+bool Dted_Cell::readPostValue(const Voxel& gridPt, double& value) const {
+    if (!containsPost(gridPt))
+        return false;
+
+    int offset = (int) (gridPt.x * theNumLatPoints + gridPt.y);
 
     // Get the post.
-    return double(convertSignedMagnitude(us));
+    value = double(residentPost(offset / theNumLatPoints,
+            offset % theNumLatPoints));
+
+    return true;
 }
 
 double Dted_Cell::getPostValueFromDisk(const Voxel& gridPt) {
+    if (thePacked || (thePageSlots != NULL))
+        return getPostValue(gridPt);
+
     boost::mutex::scoped_lock lock(sharedMutex);
 
     // Do some error checking.
@@ -408,6 +1165,10 @@ double Dted_Cell::getPostValueFromDisk(const Voxel& gridPt) {
 }
 
 void Dted_Cell::gatherStatistics() {
+    // Packed cells carry the statistics in their header.
+    if (thePacked)
+        return;
+
     boost::mutex::scoped_lock lock(sharedMutex);
 
     // Check to see if there is a statistics file already.  If so; do a lookup
@@ -17,7 +17,9 @@
 #ifndef Dted_Cell_HEADER
 #define Dted_Cell_HEADER
 
+#include <boost/atomic.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include <iostream>
@@ -25,15 +27,29 @@
 
 #include <string>
 #include "Dted_Common.h"
+#include "Dted_Compressed_Posts.h"
+#include "Dted_Min_Max_Tree.h"
+#include "Dted_Overview.h"
+#include "Dted_Page_Cache.h"
+#include "Dted_Tile_Arena.h"
 
 using namespace std;
 
+class Dted_Archive;
+
 class Dted_Cell {
 public:
 
-    //! Dted cell constructor
+    //! Dted cell constructor.  Opens either a Dted file or a packed cell
+    //! (see Dted_Packed_Format.h); packed cells are memory mapped and
+    //! their posts are resident at once.
     Dted_Cell(const string& dted_file);
 
+    //! Dted cell constructor for a cell of a mapped archive.  The cell
+    //! keeps the archive mapped.
+    Dted_Cell(const boost::shared_ptr<Dted_Archive>& archive, short latitude,
+            short longitude);
+
     virtual ~Dted_Cell();
 
     enum {
@@ -49,12 +65,155 @@ public:
     //! Retrieve Height above MSL from disk.
     double getHeightAboveMSLFromDisk(const Geo_Location& gpt);
 
+    //! Retrieve Height above MSL from memory with the given
+    //! interpolation rather than the cell's setting, so concurrent
+    //! callers may use different modes.
+    double getHeightAboveMSL(const Geo_Location& gpt,
+            Interpolation_Mode interpolation) const;
+
+    //! Retrieve Height above MSL from disk with the given interpolation.
+    double getHeightAboveMSLFromDisk(const Geo_Location& gpt,
+            Interpolation_Mode interpolation) const;
+
+    /*! Retrieve Height above MSL from an overview of the cell.  The
+     overview posts stand for the posts within half an overview spacing,
+     so nearest neighbour picks the closest overview post.
+     @param level overview level, from 1.
+     @param value set to the height, NULL_POST for void posts.
+     @return false if the location is outside the cell or the overview
+     was not built.
+     */
+    bool readOverviewHeight(const Geo_Location& gpt, int level,
+            Overview_Mode mode, Interpolation_Mode interpolation,
+            double& value) const;
+
+    //! Overviews of the cell, NULL until built.
+    inline const Dted_Overview* getOverview() const {
+        return theOverview.load(boost::memory_order_acquire);
+    }
+
+    /*! Build the overviews of the cell unless already built, from the
+     resident posts or else from the file.  Safe to call while the cell
+     is queried.
+     @param levels overview levels (see Dted_Overview).
+     @param modes Overview_Mode values or'ed together.
+     @return the overviews, which may have been built with other
+     settings by an earlier call, or NULL for cells without posts to
+     reduce (uniform cells or read errors).
+     */
+    const Dted_Overview* buildOverview(int levels, unsigned int modes);
+
+    //! Min/max hierarchy of the posts, NULL until built.
+    inline const Dted_Min_Max_Tree* getMinMaxTree() const {
+        return theMinMaxTree.load(boost::memory_order_acquire);
+    }
+
+    //! Build the min/max hierarchy of the posts unless already built, as
+    //! buildOverview() builds the overviews.
+    //! @return the hierarchy, or NULL for uniform cells or on error.
+    const Dted_Min_Max_Tree* buildMinMaxTree();
+
+    /*! Find the highest (or lowest) non void post in a range of posts,
+     through the min/max hierarchy if built, else post by post.
+     @param range posts to search, clipped to the cell.
+     @param best set to the post found.
+     @return false if the range is empty or all its posts are void.
+     */
+    bool findRegionPost(const Dted_Min_Max_Tree::Post_Range& range,
+            bool findMax, short& best) const;
+
     //! Returns the number of post in the cell.
     Cell_Size getSizeOfElevCell() const;
 
     //! Load dted cell from disk into memory.
     void loadCellFromDisk();
 
+    //! Offset in bytes of the data records from the start of the file.
+    long getDataRegionOffset() const;
+
+    //! Size in bytes of all data records (0 if the cell failed to open).
+    size_t getDataRegionSize() const;
+
+    //! Take ownership of a malloc'd buffer holding the raw data records
+    //! read from the file, and decode it in place into the resident
+    //! posts.  Used by loaders that read the data region themselves.
+    void adoptDataRegion(unsigned char* dataRegion);
+
+    //! Returns true if every post of the cell has the same value; such a
+    //! cell holds no posts.
+    bool isUniform() const;
+
+    //! Returns true if the cell was opened from a packed cell file.
+    bool isPacked() const;
+
+    //! Returns true if the posts are in memory.  Residency is fixed
+    //! once a cell is published, so this takes no lock.
+    bool isResident() const;
+
+    //! Returns true if the resident posts are held compressed.
+    bool isCompressed() const;
+
+    //! Returns true if the posts are read straight from memory, with no
+    //! decoding, allocation, lock or I/O: raw, mapped or uniform posts.
+    inline bool hasDirectPosts() const {
+        return (dtedPostMemPtr != NULL) || theUniform;
+    }
+
+    //! Fault in the direct posts and mark the cell pinned.
+    //! @param lockMemory also mlock the posts until the cell is freed.
+    //! @return Returns false if the cell has no direct posts or mlock
+    //! failed.
+    bool pinPosts(bool lockMemory);
+
+    //! Returns true once pinPosts() was called; pinned cells are never
+    //! demoted.
+    bool isPinned() const;
+
+    //! Replace the resident posts by block compressed posts, trading a
+    //! block decode on cache misses for a fraction of the memory.
+    //! Packed cells are not compressed.
+    //! @return Returns true if the posts were compressed.
+    bool compressPosts();
+
+    //! Heap bytes held by the resident posts.
+    size_t getResidentSize() const;
+
+    //! Allocate the resident posts from an arena instead of the heap.
+    //! Set it before loading; the arena must outlive the cell.
+    void setTileArena(Dted_Tile_Arena* tileArena);
+
+    //! Read the posts on demand, a page of longitude lines at a time,
+    //! through a page cache shared with other cells.  The memory
+    //! queries then serve the cell.  Has no effect on packed, resident
+    //! or unreadable cells.
+    void setPageCache(Dted_Page_Cache* pageCache);
+
+    //! Returns true if the posts are read through a page cache.
+    bool isPaged() const;
+
+    //! Count a query of the cell.
+    //! @return Returns the count including this query.
+    inline unsigned int recordAccess() {
+        return theAccessCount.fetch_add(1, boost::memory_order_relaxed) + 1;
+    }
+
+    //! Return the number of queries counted by recordAccess().
+    unsigned int getAccessCount() const;
+
+    //! Set the query count, e.g. to age it or carry it to a new copy.
+    void setAccessCount(unsigned int accessCount);
+
+    //! Return the south west corner post of the cell.
+    Geo_Location getSwCornerPost() const;
+
+    //! Write the cell as a packed cell file, loading it if needed.
+    //! @return Returns true on success, false on error.
+    bool writePacked(const string& packedFile);
+
+    //! Write the packed cell image to a stream.
+    //! @return Returns true on success, false on error.
+    bool writePacked(ostream& packedStr);
+
     //! Enable/Disable bilinear intepolation
     void setBilinearInterpActive(bool newState);
 
@@ -64,6 +223,17 @@ public:
     //! Returns an elevation post from a dted cell in memory.
     double getPostValue(const Voxel& gridPt);
 
+    //! Returns true if the post index lies within the cell.
+    inline bool containsPost(const Voxel& gridPt) const {
+        return (gridPt.x >= 0.0) && (gridPt.y >= 0.0)
+                && (gridPt.x <= theNumLonLines - 1)
+                && (gridPt.y <= theNumLatPoints - 1);
+    }
+
+    //! Read an elevation post from memory without logging.
+    //! @return Returns false if the post is outside the cell.
+    bool readPostValue(const Voxel& gridPt, double& value) const;
+
     //! Return the Dted edition.
     string edition() const;
 
@@ -98,7 +268,7 @@ public:
     //! p10: Post 3 (Bottom right)
     //! p11: Post 4 (Top right)
     double bilinearInterpolate(double xi, double yi, double p00, double p01,
-            double p10, double p11);
+            double p10, double p11) const;
 
 private:
 
@@ -109,8 +279,67 @@ private:
     Dted_Cell(const Dted_Cell&) {
     }
 
+    //! Map the posts of a packed cell file.
+    bool openPacked();
+
+    //! Use the posts of a packed cell image held in memory.
+    bool attachPacked(const unsigned char* packedImage, size_t imageSize);
+
+    friend class Dted_Page_Cache;
+
+    //! Return a resident post, raw, uniform, compressed or paged.
+    inline short residentPost(int x, int y) const {
+        if (dtedPostMemPtr != NULL)
+            return dtedPostMemPtr[x * theNumLatPoints + y];
+
+        if (theUniform)
+            return theUniformValue;
+
+        if (theCompressedPosts != NULL)
+            return theCompressedPosts->Get_Post(x, y);
+
+        return pagedPost(x, y);
+    }
+
+    //! Return a post through the page cache.
+    short pagedPost(int x, int y) const;
+
+    //! Page table entry of a page.
+    Dted_Page_Cache::Page_Slot* pageSlot(int page) const;
+
+    //! Read and decode the longitude lines of a page.
+    //! @param size set to the bytes of the returned posts.
+    //! @return malloc'd posts, or NULL on error.
+    short* readPage(int page, size_t& size);
+
+    //! Strip the record framing of numLines raw data records and convert
+    //! their posts to native shorts, into posts or, if NULL, in place.
+    short* decodeRecords(unsigned char* records, int numLines,
+            short* posts);
+
+    //! Decode every post of a cell without direct posts, from the
+    //! compressed posts or else the file.
+    //! @return malloc'd posts, or NULL on error.
+    short* decodeAllPosts();
+
+    //! Return posts y0 to y1 of longitude line x in posts, read from
+    //! the file in one read if the cell holds no posts.
+    void regionPosts(int x, int y0, int y1, short* posts) const;
+
+    //! Post accessor of the min/max hierarchy.
+    struct Region_Posts {
+        const Dted_Cell* cell;
+
+        inline void operator()(int x, int y0, int y1, short* posts) const {
+            cell->regionPosts(x, y0, y1, posts);
+        }
+    };
+
+    //! Free heap or arena posts.
+    void releasePosts();
+
     //! Convert unsigned short to signed magnitude.
-    inline signed short convertSignedMagnitude(unsigned short& s) {
+    inline signed short convertSignedMagnitude(unsigned short& s) const {
         s = (byteSwap ? ((s << 8) | (s >> 8)) : s);
 
         if (s & 0x8000)
@@ -143,7 +372,43 @@ private:
 
     mutable boost::mutex sharedMutex;
 
-    unsigned char* dtedPostMemPtr;
+    //! Resident posts decoded to native shorts, one longitude line
+    //! (theNumLatPoints posts, south to north) after the other.
+    short* dtedPostMemPtr;
+
+    //! Mapping of a packed cell file, which holds dtedPostMemPtr.
+    bool thePacked;
+    void* theMappedRegion;
+    size_t theMappedSize;
+
+    //! Archive holding dtedPostMemPtr for an archived cell.
+    boost::shared_ptr<Dted_Archive> theArchive;
+
+    //! Resident posts when compressed, in place of dtedPostMemPtr.
+    Dted_Compressed_Posts* theCompressedPosts;
+
+    //! Value of every post of a uniform cell, which holds no posts.
+    bool theUniform;
+    short theUniformValue;
+
+    //! Arena of the posts, and whether dtedPostMemPtr came from it.
+    Dted_Tile_Arena* theTileArena;
+    bool theArenaPosts;
+
+    //! Page cache and page table of a paged cell.
+    Dted_Page_Cache* thePageCache;
+    Dted_Page_Cache::Page_Slot* thePageSlots;
+
+    //! Queries counted for HYBRID_ACCESS residency.
+    boost::atomic<unsigned int> theAccessCount;
+
+    //! Set by pinPosts(); theLockedPosts if the posts are mlocked.
+    boost::atomic<bool> thePinned;
+    bool theLockedPosts;
+
+    //! Set once by buildOverview() and buildMinMaxTree().
+    boost::atomic<Dted_Overview*> theOverview;
+    boost::atomic<Dted_Min_Max_Tree*> theMinMaxTree;
 
     bool debug;
 };
@@ -0,0 +1,119 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Index of the loaded Dted cells of one level, one slot
+//               per one degree cell of the globe.
+//
+//********************************************************************
+
+#include <math.h>
+
+#include "Dted_Cell_Grid.h"
+
+Dted_Cell_Grid::Dted_Cell_Grid() {
+    slots = new boost::atomic<Dted_Cell*>[NUM_PARALLELS * NUM_MERIDIANS];
+
+    for (int i = 0; i < NUM_PARALLELS * NUM_MERIDIANS; i++)
+        slots[i].store(NULL);
+}
+
+Dted_Cell_Grid::~Dted_Cell_Grid() {
+    // Cells are owned by the Dted_Database; only the index is freed here.
+    delete[] slots;
+}
+
+bool Dted_Cell_Grid::Is_Valid(short latitude, short longitude) {
+    return (latitude >= -NUM_PARALLELS / 2) && (latitude < NUM_PARALLELS / 2)
+            && (longitude >= -NUM_MERIDIANS / 2)
+            && (longitude < NUM_MERIDIANS / 2);
+}
+
+void Dted_Cell_Grid::Cell_Corner(const Geo_Location& geoLoc, short& latitude,
+        short& longitude) {
+    latitude = (short) floor(geoLoc.lat);
+    longitude = (short) floor(geoLoc.lon);
+}
+
+Dted_Cell* Dted_Cell_Grid::Get(short latitude, short longitude) const {
+    if (!Is_Valid(latitude, longitude))
+        return NULL;
+
+    return slots[Slot_Index(latitude, longitude)].load();
+}
+
+Dted_Cell* Dted_Cell_Grid::Find(const Geo_Location& geoLoc) const {
+    short latitude;
+    short longitude;
+
+    Cell_Corner(geoLoc, latitude, longitude);
+
+    Dted_Cell* dtedCellPtr = Get(latitude, longitude);
+
+    if ((dtedCellPtr != NULL) && dtedCellPtr->covers(geoLoc))
+        return dtedCellPtr;
+
+    return NULL;
+}
+
+bool Dted_Cell_Grid::Publish(short latitude, short longitude,
+        Dted_Cell* dtedCellPtr) {
+    if (!Is_Valid(latitude, longitude))
+        return false;
+
+    Dted_Cell* expected = NULL;
+
+    return slots[Slot_Index(latitude, longitude)].compare_exchange_strong(
+            expected, dtedCellPtr);
+}
+
+Dted_Cell* Dted_Cell_Grid::Exchange(short latitude, short longitude,
+        Dted_Cell* dtedCellPtr) {
+    if (!Is_Valid(latitude, longitude))
+        return NULL;
+
+    return slots[Slot_Index(latitude, longitude)].exchange(dtedCellPtr);
+}
+
+bool Dted_Cell_Grid::Replace(short latitude, short longitude,
+        Dted_Cell* expected, Dted_Cell* desired) {
+    if (!Is_Valid(latitude, longitude))
+        return false;
+
+    return slots[Slot_Index(latitude, longitude)].compare_exchange_strong(
+            expected, desired);
+}
+
+void Dted_Cell_Grid::Clear(vector<Dted_Cell*>& cells) {
+    for (int i = 0; i < NUM_PARALLELS * NUM_MERIDIANS; i++) {
+        Dted_Cell* dtedCellPtr = slots[i].exchange(NULL);
+
+        if (dtedCellPtr != NULL)
+            cells.push_back(dtedCellPtr);
+    }
+}
+
+void Dted_Cell_Grid::Snapshot(vector<Dted_Cell*>& cells) const {
+    for (int i = 0; i < NUM_PARALLELS * NUM_MERIDIANS; i++) {
+        Dted_Cell* dtedCellPtr = slots[i].load();
+
+        if (dtedCellPtr != NULL)
+            cells.push_back(dtedCellPtr);
+    }
+}
+
+int Dted_Cell_Grid::Size() const {
+    int size = 0;
+
+    for (int i = 0; i < NUM_PARALLELS * NUM_MERIDIANS; i++) {
+        if (slots[i].load() != NULL)
+            size++;
+    }
+
+    return size;
+}
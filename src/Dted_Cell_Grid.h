@@ -0,0 +1,90 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Index of the loaded Dted cells of one level, one slot
+//               per one degree cell of the globe.  Lookups are lock-free
+//               and may run concurrently with Publish/Exchange; readers
+//               must hold a Dted_Epoch::Guard of the epoch that retires
+//               the cells removed from the grid.
+//
+//********************************************************************
+
+#ifndef Dted_Cell_Grid_H
+#define Dted_Cell_Grid_H
+
+#include <vector>
+
+#include <boost/atomic.hpp>
+
+#include "Dted_Cell.h"
+#include "Dted_Common.h"
+
+using namespace std;
+
+class Dted_Cell_Grid {
+public:
+
+    enum {
+        NUM_PARALLELS = 180, NUM_MERIDIANS = 360
+    };
+
+    Dted_Cell_Grid();
+    ~Dted_Cell_Grid();
+
+    //! Returns the cell whose south west corner is (latitude, longitude),
+    //! or NULL if none is loaded.
+    Dted_Cell* Get(short latitude, short longitude) const;
+
+    //! Returns the cell covering the geo location, or NULL.
+    Dted_Cell* Find(const Geo_Location& geoLoc) const;
+
+    //! Publish a cell into an empty slot.
+    //! @return false if the slot was already occupied (cell not stored).
+    bool Publish(short latitude, short longitude, Dted_Cell* dtedCellPtr);
+
+    //! Replace the cell in a slot (NULL unloads).
+    //! @return the previous cell which the caller must retire.
+    Dted_Cell* Exchange(short latitude, short longitude,
+            Dted_Cell* dtedCellPtr);
+
+    //! Replace the cell in a slot only if it still holds expected.
+    //! @return false if the slot changed (desired not stored).
+    bool Replace(short latitude, short longitude, Dted_Cell* expected,
+            Dted_Cell* desired);
+
+    //! Empty the grid, appending the removed cells to cells.
+    void Clear(vector<Dted_Cell*>& cells);
+
+    //! Append every loaded cell to cells.
+    void Snapshot(vector<Dted_Cell*>& cells) const;
+
+    //! Number of loaded cells.
+    int Size() const;
+
+    //! Returns true if the lat/lon corner lies on the globe.
+    static bool Is_Valid(short latitude, short longitude);
+
+    //! South west corner of the one degree cell holding the location.
+    static void Cell_Corner(const Geo_Location& geoLoc, short& latitude,
+            short& longitude);
+
+private:
+
+    Dted_Cell_Grid(const Dted_Cell_Grid&);
+    const Dted_Cell_Grid& operator=(const Dted_Cell_Grid&);
+
+    static int Slot_Index(short latitude, short longitude) {
+        return (latitude + NUM_PARALLELS / 2) * NUM_MERIDIANS
+                + (longitude + NUM_MERIDIANS / 2);
+    }
+
+    boost::atomic<Dted_Cell*>* slots;
+};
+
+#endif
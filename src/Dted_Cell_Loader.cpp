@@ -0,0 +1,491 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  I/O scheduler loading Dted cells on behalf of the
+//               Dted_Database.
+//
+//********************************************************************
+
+#include <sys/stat.h>
+
+#include <boost/bind/bind.hpp>
+
+#include "Dted_Cell_Loader.h"
+
+Dted_Load_Handle::State::State() :
+        requested(0),
+        loaded(0),
+        failed(0),
+        committed(false),
+        cancelled(false) {
+}
+
+bool Dted_Load_Handle::State::Is_Done() const {
+    return committed && ((loaded + failed) == requested);
+}
+
+Dted_Load_Handle::Dted_Load_Handle() :
+        state(new State()) {
+    state->committed = true;
+}
+
+bool Dted_Load_Handle::Is_Done() const {
+    boost::mutex::scoped_lock lock(state->mutex);
+    return state->Is_Done();
+}
+
+void Dted_Load_Handle::Wait() const {
+    boost::mutex::scoped_lock lock(state->mutex);
+
+    while (!state->Is_Done())
+        state->done.wait(lock);
+}
+
+bool Dted_Load_Handle::Wait_For(long milliseconds) const {
+    boost::mutex::scoped_lock lock(state->mutex);
+    boost::system_time timeout = boost::get_system_time()
+            + boost::posix_time::milliseconds(milliseconds);
+
+    while (!state->Is_Done()) {
+        if (!state->done.timed_wait(lock, timeout))
+            return state->Is_Done();
+    }
+
+    return true;
+}
+
+void Dted_Load_Handle::Cancel() {
+    boost::mutex::scoped_lock lock(state->mutex);
+    state->cancelled = true;
+}
+
+bool Dted_Load_Handle::Is_Cancelled() const {
+    boost::mutex::scoped_lock lock(state->mutex);
+    return state->cancelled;
+}
+
+int Dted_Load_Handle::Get_Requested() const {
+    boost::mutex::scoped_lock lock(state->mutex);
+    return state->requested;
+}
+
+int Dted_Load_Handle::Get_Loaded() const {
+    boost::mutex::scoped_lock lock(state->mutex);
+    return state->loaded;
+}
+
+int Dted_Load_Handle::Get_Failed() const {
+    boost::mutex::scoped_lock lock(state->mutex);
+    return state->failed;
+}
+
+Dted_Cell_Loader::Dted_Cell_Loader(const Load_Function& loadFunction,
+        const Batch_Load_Function& batchLoadFunction) :
+        loadFunction(loadFunction),
+        batchLoadFunction(batchLoadFunction),
+        deviceConcurrency(DEFAULT_DEVICE_CONCURRENCY),
+        activeJobs(0),
+        stopping(false),
+        threadCount(boost::thread::hardware_concurrency()),
+        threadsStarted(false),
+        runningThreads(0) {
+    if (threadCount < 1)
+        threadCount = 1;
+}
+
+Dted_Cell_Loader::~Dted_Cell_Loader() {
+    Cancel_All();
+    Stop_Threads();
+}
+
+void Dted_Cell_Loader::Set_Thread_Count(int newThreadCount) {
+    {
+        boost::mutex::scoped_lock lock(queueMutex);
+        threadCount = (newThreadCount < 1) ? 1 : newThreadCount;
+
+        if (threadsStarted && !stopping)
+            Resize_Threads();
+    }
+
+    // Wake surplus threads so that they leave.
+    queueChanged.notify_all();
+}
+
+void Dted_Cell_Loader::Set_Device_Concurrency(int newDeviceConcurrency) {
+    {
+        boost::mutex::scoped_lock lock(queueMutex);
+        deviceConcurrency =
+                (newDeviceConcurrency < 1) ? 1 : newDeviceConcurrency;
+    }
+
+    queueChanged.notify_all();
+}
+
+Dted_Cell_Loader::Cell_Key Dted_Cell_Loader::Key(const Load_Request& request) {
+    return Cell_Key(request.level,
+            pair<short, short>(request.entry.latitude,
+                    request.entry.longitude));
+}
+
+void Dted_Cell_Loader::Start_Threads() {
+    // Called with queueMutex held.
+    if (threadsStarted)
+        return;
+
+    threadsStarted = true;
+
+    Resize_Threads();
+}
+
+void Dted_Cell_Loader::Resize_Threads() {
+    // Threads that left hold no lock once they have; joining is quick.
+    for (size_t i = 0; i < leftThreads.size(); i++) {
+        map<boost::thread::id, boost::thread*>::iterator it =
+                threads.find(leftThreads[i]);
+
+        if (it != threads.end()) {
+            it->second->join();
+            delete it->second;
+            threads.erase(it);
+        }
+    }
+
+    leftThreads.clear();
+
+    // A new thread waits for queueMutex before it looks at the queues.
+    while (runningThreads < threadCount) {
+        boost::thread* thread = new boost::thread(
+                boost::bind(&Dted_Cell_Loader::Worker, this));
+
+        threads[thread->get_id()] = thread;
+        runningThreads++;
+    }
+}
+
+void Dted_Cell_Loader::Stop_Threads() {
+    map<boost::thread::id, boost::thread*> stoppedThreads;
+
+    {
+        boost::mutex::scoped_lock lock(queueMutex);
+        stopping = true;
+
+        // No thread is started once stopping is set.
+        stoppedThreads.swap(threads);
+    }
+
+    queueChanged.notify_all();
+
+    for (map<boost::thread::id, boost::thread*>::iterator it =
+            stoppedThreads.begin(); it != stoppedThreads.end(); ++it) {
+        it->second->join();
+        delete it->second;
+    }
+}
+
+Dted_Load_Handle Dted_Cell_Loader::Begin_Batch() {
+    Dted_Load_Handle handle;
+
+    handle.state->committed = false;
+
+    return handle;
+}
+
+void Dted_Cell_Loader::Submit(Dted_Load_Handle& handle,
+        const Load_Request& request, Load_Priority priority) {
+    {
+        boost::mutex::scoped_lock lock(handle.state->mutex);
+        handle.state->requested++;
+    }
+
+    struct stat fileStat;
+    dev_t device = 0;
+
+    if (stat(request.entry.cellPath.c_str(), &fileStat) == 0)
+        device = fileStat.st_dev;
+
+    {
+        boost::mutex::scoped_lock lock(queueMutex);
+
+        Start_Threads();
+
+        map<Cell_Key, Job_Ptr>::iterator it = jobMap.find(Key(request));
+
+        if (it != jobMap.end()) {
+            // Merge with the pending or running load of the same cell.
+            Job_Ptr job = it->second;
+
+            job->waiters.push_back(handle.state);
+            job->request.loadPosts = job->request.loadPosts
+                    || request.loadPosts;
+
+            if (job->queued && (priority < job->priority)) {
+                // Promote; the entry in the old queue turns stale.
+                job->priority = priority;
+                jobQueues[priority].push_back(job);
+            }
+        } else {
+            Job_Ptr job(new Job());
+
+            job->request = request;
+            job->priority = priority;
+            job->device = device;
+            job->queued = true;
+            job->waiters.push_back(handle.state);
+
+            jobMap[Key(request)] = job;
+            jobQueues[priority].push_back(job);
+        }
+    }
+
+    queueChanged.notify_one();
+}
+
+void Dted_Cell_Loader::Commit(Dted_Load_Handle& handle) {
+    boost::mutex::scoped_lock lock(handle.state->mutex);
+
+    handle.state->committed = true;
+
+    if (handle.state->Is_Done())
+        handle.state->done.notify_all();
+}
+
+bool Dted_Cell_Loader::Load_Now(const Load_Request& request) {
+    State_Ptr state(new Dted_Load_Handle::State());
+
+    state->requested = 1;
+    state->committed = true;
+
+    struct stat fileStat;
+    dev_t device = 0;
+
+    if (stat(request.entry.cellPath.c_str(), &fileStat) == 0)
+        device = fileStat.st_dev;
+
+    boost::mutex::scoped_lock lock(queueMutex);
+
+    map<Cell_Key, Job_Ptr>::iterator it = jobMap.find(Key(request));
+
+    if (it == jobMap.end()) {
+        Job_Ptr job(new Job());
+
+        job->request = request;
+        job->priority = LOAD_FOREGROUND;
+        job->device = device;
+        job->queued = false;
+        job->waiters.push_back(state);
+
+        jobMap[Key(request)] = job;
+
+        Run_Job(lock, job);
+    } else if (it->second->queued) {
+        // Take the queued load over instead of waiting for a thread.
+        Job_Ptr job = it->second;
+
+        job->queued = false;
+        job->priority = LOAD_FOREGROUND;
+        job->waiters.push_back(state);
+        job->request.loadPosts = job->request.loadPosts || request.loadPosts;
+
+        Run_Job(lock, job);
+    } else {
+        // Already running: wait for it.
+        it->second->waiters.push_back(state);
+    }
+
+    lock.unlock();
+
+    Dted_Load_Handle handle;
+    handle.state = state;
+    handle.Wait();
+
+    return handle.Get_Loaded() > 0;
+}
+
+int Dted_Cell_Loader::Get_Queue_Length(Load_Priority priority) const {
+    boost::mutex::scoped_lock lock(queueMutex);
+
+    int length = 0;
+
+    for (size_t i = 0; i < jobQueues[priority].size(); i++) {
+        const Job& job = *jobQueues[priority][i];
+
+        if (job.queued && (job.priority == priority))
+            length++;
+    }
+
+    return length;
+}
+
+void Dted_Cell_Loader::Cancel_All() {
+    boost::mutex::scoped_lock lock(queueMutex);
+
+    for (int priority = 0; priority < NUM_LOAD_PRIORITIES; priority++) {
+        deque<Job_Ptr>& jobQueue = jobQueues[priority];
+
+        for (size_t i = 0; i < jobQueue.size(); i++) {
+            Job& job = *jobQueue[i];
+
+            if (!job.queued || (job.priority != priority))
+                continue;
+
+            job.queued = false;
+            jobMap.erase(Key(job.request));
+
+            for (size_t j = 0; j < job.waiters.size(); j++)
+                Complete(*job.waiters[j], false);
+        }
+
+        jobQueue.clear();
+    }
+
+    while (activeJobs > 0)
+        jobsIdle.wait(lock);
+}
+
+bool Dted_Cell_Loader::Is_Abandoned(const Job& job) {
+    for (size_t i = 0; i < job.waiters.size(); i++) {
+        boost::mutex::scoped_lock lock(job.waiters[i]->mutex);
+
+        if (!job.waiters[i]->cancelled)
+            return false;
+    }
+
+    return true;
+}
+
+void Dted_Cell_Loader::Complete(Dted_Load_Handle::State& state, bool loaded) {
+    boost::mutex::scoped_lock lock(state.mutex);
+
+    if (loaded)
+        state.loaded++;
+    else
+        state.failed++;
+
+    if (state.Is_Done())
+        state.done.notify_all();
+}
+
+void Dted_Cell_Loader::Next_Jobs(vector<Job_Ptr>& jobs) {
+    size_t maxJobs = batchLoadFunction ? MAX_BATCH_SIZE : 1;
+    set<dev_t> devices;
+
+    for (int priority = 0; priority < NUM_LOAD_PRIORITIES; priority++) {
+        deque<Job_Ptr>& jobQueue = jobQueues[priority];
+        deque<Job_Ptr>::iterator it = jobQueue.begin();
+
+        while ((it != jobQueue.end()) && (jobs.size() < maxJobs)) {
+            Job_Ptr job = *it;
+
+            if (!job->queued || (job->priority != priority)) {
+                // Promoted or taken over by a foreground load.
+                it = jobQueue.erase(it);
+            } else if (Is_Abandoned(*job)) {
+                // Stale: every batch that wanted it was cancelled.
+                it = jobQueue.erase(it);
+                job->queued = false;
+                jobMap.erase(Key(job->request));
+
+                for (size_t i = 0; i < job->waiters.size(); i++)
+                    Complete(*job->waiters[i], false);
+            } else if ((devices.count(job->device) > 0)
+                    || (deviceLoads[job->device] < deviceConcurrency)) {
+                it = jobQueue.erase(it);
+                job->queued = false;
+                devices.insert(job->device);
+
+                jobs.push_back(job);
+            } else {
+                // Device saturated; look for work on another device.
+                it++;
+            }
+        }
+
+        // Never mix priority classes in one batch.
+        if (!jobs.empty())
+            return;
+    }
+}
+
+void Dted_Cell_Loader::Run_Job(boost::mutex::scoped_lock& lock,
+        const Job_Ptr& job) {
+    Run_Jobs(lock, vector<Job_Ptr>(1, job));
+}
+
+void Dted_Cell_Loader::Run_Jobs(boost::mutex::scoped_lock& lock,
+        const vector<Job_Ptr>& jobs) {
+    set<dev_t> devices;
+    vector<Load_Request> requests;
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        devices.insert(jobs[i]->device);
+        requests.push_back(jobs[i]->request);
+    }
+
+    for (set<dev_t>::iterator it = devices.begin(); it != devices.end(); it++)
+        deviceLoads[*it]++;
+
+    activeJobs += jobs.size();
+
+    lock.unlock();
+
+    vector<bool> loaded(requests.size(), false);
+
+    if ((requests.size() == 1) || !batchLoadFunction)
+        loaded[0] = loadFunction(requests[0]);
+    else
+        batchLoadFunction(requests, loaded);
+
+    lock.lock();
+
+    for (set<dev_t>::iterator it = devices.begin(); it != devices.end(); it++)
+        deviceLoads[*it]--;
+
+    activeJobs -= jobs.size();
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const Job_Ptr& job = jobs[i];
+        map<Cell_Key, Job_Ptr>::iterator it = jobMap.find(Key(requests[i]));
+
+        if ((it != jobMap.end()) && (it->second == job))
+            jobMap.erase(it);
+
+        for (size_t j = 0; j < job->waiters.size(); j++)
+            Complete(*job->waiters[j], loaded[i]);
+
+        job->waiters.clear();
+    }
+
+    // A device slot was freed.
+    queueChanged.notify_all();
+
+    if (activeJobs == 0)
+        jobsIdle.notify_all();
+}
+
+void Dted_Cell_Loader::Worker() {
+    boost::mutex::scoped_lock lock(queueMutex);
+
+    while (!stopping) {
+        if (runningThreads > threadCount) {
+            // Leave the pool after a shrink.
+            runningThreads--;
+            leftThreads.push_back(boost::this_thread::get_id());
+            return;
+        }
+
+        vector<Job_Ptr> jobs;
+
+        Next_Jobs(jobs);
+
+        if (!jobs.empty())
+            Run_Jobs(lock, jobs);
+        else
+            queueChanged.wait(lock);
+    }
+}
@@ -0,0 +1,254 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  I/O scheduler loading Dted cells on behalf of the
+//               Dted_Database.  Loads are queued in priority classes
+//               (foreground query miss > explicit prefetch >
+//               speculative/preload), run on background threads with a
+//               bounded number of concurrent loads per storage device,
+//               and are merged when several batches ask for the same
+//               cell.  A foreground miss never waits behind queued
+//               loads: it runs on the calling thread, taking over the
+//               queued load of its cell if there is one.  Each batch of
+//               submitted loads reports its progress through a
+//               Dted_Load_Handle.  With a batch load function a thread
+//               takes up to MAX_BATCH_SIZE queued loads of one priority
+//               class at a time so that their reads can be in flight
+//               together.
+//
+//********************************************************************
+
+#ifndef Dted_Cell_Loader_H
+#define Dted_Cell_Loader_H
+
+#include <sys/types.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Dted_Cell_Path_Entry.h"
+#include "Dted_Common.h"
+
+using namespace std;
+
+//! Completion handle of a batch of background cell loads.
+class Dted_Load_Handle {
+public:
+
+    //! An empty handle which is already complete.
+    Dted_Load_Handle();
+
+    //! Returns true once every load of the batch has finished.
+    bool Is_Done() const;
+
+    //! Block until every load of the batch has finished.
+    void Wait() const;
+
+    //! Block at most milliseconds for the batch.
+    //! @return true if the batch finished.
+    bool Wait_For(long milliseconds) const;
+
+    //! Drop the loads of the batch that have not started yet.  Loads
+    //! shared with another live batch still run for that batch.
+    void Cancel();
+
+    //! Returns true if the batch was cancelled.
+    bool Is_Cancelled() const;
+
+    //! Number of loads in the batch.
+    int Get_Requested() const;
+
+    //! Number of loads that produced a cell.
+    int Get_Loaded() const;
+
+    //! Number of loads that failed or were cancelled.
+    int Get_Failed() const;
+
+private:
+
+    friend class Dted_Cell_Loader;
+
+    struct State {
+        State();
+
+        //! Returns true once committed and every load has finished.
+        bool Is_Done() const;
+
+        mutable boost::mutex mutex;
+        mutable boost::condition_variable done;
+
+        int requested;
+        int loaded;
+        int failed;
+        bool committed;
+        bool cancelled;
+    };
+
+    boost::shared_ptr<State> state;
+};
+
+class Dted_Cell_Loader {
+public:
+
+    enum {
+        DEFAULT_DEVICE_CONCURRENCY = 4, // Background loads per device
+        MAX_BATCH_SIZE = 64 // Loads handed to the batch load function
+    };
+
+    //! A single cell load.
+    struct Load_Request {
+        Dted_Level level;
+        Dted_Cell_Path_Entry entry;
+        //! Load the posts into memory rather than only opening the cell.
+        bool loadPosts;
+    };
+
+    //! Performs a load; returns true if the cell was loaded.
+    typedef boost::function<bool(const Load_Request&)> Load_Function;
+
+    //! Performs several loads at once; sets loaded[i] for requests[i].
+    typedef boost::function<void(const vector<Load_Request>&, vector<bool>&)>
+            Batch_Load_Function;
+
+    /*! Constructor.
+     @param loadFunction performs single loads.
+     @param batchLoadFunction optionally performs background loads in
+     batches; a batch occupies one slot of each device it reads from.
+     */
+    Dted_Cell_Loader(const Load_Function& loadFunction,
+            const Batch_Load_Function& batchLoadFunction =
+                    Batch_Load_Function());
+
+    //! Cancels queued loads and joins the threads.
+    ~Dted_Cell_Loader();
+
+    //! Set the number of loader threads (default: hardware threads).
+    //! May be called at any time: threads are added at once, and
+    //! surplus threads leave once their current loads finish.
+    void Set_Thread_Count(int threadCount);
+
+    //! Set the number of concurrent background loads per device.
+    void Set_Device_Concurrency(int deviceConcurrency);
+
+    //! Start a new batch.  Loads are queued with Submit() and the batch
+    //! is released to the threads by Commit().
+    Dted_Load_Handle Begin_Batch();
+
+    //! Queue a load for a batch in a priority class.
+    void Submit(Dted_Load_Handle& handle, const Load_Request& request,
+            Load_Priority priority);
+
+    //! Release the batch; an empty batch completes immediately.
+    void Commit(Dted_Load_Handle& handle);
+
+    //! Perform a foreground load on the calling thread, or wait for the
+    //! load of the same cell already running.
+    //! @return true if the cell was loaded.
+    bool Load_Now(const Load_Request& request);
+
+    //! Number of loads queued in a priority class.
+    int Get_Queue_Length(Load_Priority priority) const;
+
+    //! Drop every queued load and wait for running loads to finish.
+    void Cancel_All();
+
+private:
+
+    Dted_Cell_Loader(const Dted_Cell_Loader&);
+    const Dted_Cell_Loader& operator=(const Dted_Cell_Loader&);
+
+    typedef boost::shared_ptr<Dted_Load_Handle::State> State_Ptr;
+
+    //! Pending or running load of one cell, shared by all its batches.
+    struct Job {
+        Load_Request request;
+        Load_Priority priority;
+        dev_t device;
+        //! True while the job waits in jobQueues[priority].
+        bool queued;
+        vector<State_Ptr> waiters;
+    };
+
+    typedef boost::shared_ptr<Job> Job_Ptr;
+
+    //! (level, latitude, longitude) of a cell.
+    typedef pair<int, pair<short, short> > Cell_Key;
+
+    static Cell_Key Key(const Load_Request& request);
+
+    void Start_Threads();
+    void Stop_Threads();
+
+    //! Join the threads that left the pool and start threads until
+    //! threadCount run.  Called with queueMutex held.
+    void Resize_Threads();
+
+    void Worker();
+
+    //! Take the most urgent runnable jobs of one priority class off the
+    //! queues, completing cancelled jobs on the way.  Called with
+    //! queueMutex held.
+    void Next_Jobs(vector<Job_Ptr>& jobs);
+
+    //! Perform a job; called and returns with queueMutex held.
+    void Run_Job(boost::mutex::scoped_lock& lock, const Job_Ptr& job);
+
+    //! Perform jobs together; called and returns with queueMutex held.
+    void Run_Jobs(boost::mutex::scoped_lock& lock, const vector<Job_Ptr>& jobs);
+
+    //! Returns true if every batch waiting on the job was cancelled.
+    static bool Is_Abandoned(const Job& job);
+
+    //! Record the outcome of one job of a batch.
+    static void Complete(Dted_Load_Handle::State& state, bool loaded);
+
+    Load_Function loadFunction;
+    Batch_Load_Function batchLoadFunction;
+
+    mutable boost::mutex queueMutex;
+    boost::condition_variable queueChanged;
+    boost::condition_variable jobsIdle;
+
+    //! Queued jobs per priority class.  Entries whose job has since
+    //! been promoted or taken over are dropped when reached.
+    deque<Job_Ptr> jobQueues[NUM_LOAD_PRIORITIES];
+
+    //! Queued and running jobs by cell.
+    map<Cell_Key, Job_Ptr> jobMap;
+
+    //! Running loads per device.
+    map<dev_t, int> deviceLoads;
+    int deviceConcurrency;
+
+    //! Loads currently being performed, guarded by queueMutex.
+    int activeJobs;
+
+    bool stopping;
+    int threadCount;
+    bool threadsStarted;
+
+    //! Loader threads by id, and the number of them still taking jobs;
+    //! guarded by queueMutex.
+    map<boost::thread::id, boost::thread*> threads;
+    int runningThreads;
+
+    //! Threads that left the pool after a shrink and await joining.
+    vector<boost::thread::id> leftThreads;
+};
+
+#endif
@@ -19,7 +19,7 @@ bool Dted_Cell_Path_Entry::operator <(
         const Dted_Cell_Path_Entry& other_Dted_Cell_Path_Entry) const {
     if (latitude < other_Dted_Cell_Path_Entry.latitude)
         return true;
-    else if (other_Dted_Cell_Path_Entry.latitude > latitude)
+    else if (other_Dted_Cell_Path_Entry.latitude < latitude)
         return false;
 
     if (longitude < other_Dted_Cell_Path_Entry.longitude)
@@ -16,8 +16,12 @@
 
 #include <string>
 
+#include <boost/shared_ptr.hpp>
+
 using namespace std;
 
+class Dted_Archive;
+
 class Dted_Cell_Path_Entry {
 public:
 
@@ -30,6 +34,9 @@ public:
     //! DTED cell path.
     string cellPath;
 
+    //! Archive holding the cell, if it was found in an archive.
+    boost::shared_ptr<Dted_Archive> archive;
+
     bool operator <(
             const Dted_Cell_Path_Entry& other_Dted_Cell_Path_Entry) const;
 
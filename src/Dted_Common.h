@@ -26,9 +26,46 @@ enum ByteOrder {
     ARCH_LITTLE_ENDIAN = 0, ARCH_BIG_ENDIAN
 };
 
-//! Access method
+//! Access method.  COMPRESSED_ACCESS keeps the posts resident as in
+//! MEMORY_ACCESS but block compressed (see Dted_Compressed_Posts).
+//! HYBRID_ACCESS serves cells from disk and keeps the most queried ones
+//! resident within a memory budget.  PAGED_ACCESS reads the posts a page
+//! of longitude lines at a time into a shared page cache (see
+//! Dted_Page_Cache).
 enum Access_Method {
-    MEMORY_ACCESS = 0, DISK_ACCESS
+    MEMORY_ACCESS = 0, DISK_ACCESS, COMPRESSED_ACCESS, HYBRID_ACCESS,
+    PAGED_ACCESS
+};
+
+//! NUMA placement of the resident posts.  NUMA_INTERLEAVE alternates
+//! neighbouring cells between nodes; NUMA_SPATIAL gives each node a band
+//! of longitudes.
+enum Numa_Placement {
+    NUMA_NONE = 0, NUMA_INTERLEAVE, NUMA_SPATIAL
+};
+
+//! Outcome of a query.  QUERY_VOID_POST: the post is void (NULL_POST).
+//! QUERY_NO_COVERAGE: no cell of the level covers the location.
+//! QUERY_NOT_RESIDENT: the cell covering the location is not loaded with
+//! directly readable posts, so answering would need a load.
+//! QUERY_OUT_OF_RANGE: the location or post index is invalid.
+enum Query_Status {
+    QUERY_OK = 0, QUERY_VOID_POST, QUERY_NO_COVERAGE, QUERY_NOT_RESIDENT,
+    QUERY_OUT_OF_RANGE
+};
+
+//! What an overview post holds (see Dted_Overview).  The values are
+//! bits, or'ed together to select the overviews built.
+enum Overview_Mode {
+    OVERVIEW_DECIMATE = 1, // The post at the overview post
+    OVERVIEW_AVERAGE = 2,  // Mean of the posts around it
+    OVERVIEW_MIN = 4,      // Lowest post around it
+    OVERVIEW_MAX = 8       // Highest post around it
+};
+
+//! Priority classes of cell loads, most urgent first.
+enum Load_Priority {
+    LOAD_FOREGROUND = 0, LOAD_PREFETCH, LOAD_SPECULATIVE, NUM_LOAD_PRIORITIES
 };
 
 //! Defines the DTED_Level for a cell.
@@ -57,6 +94,14 @@ typedef struct {
     double lon;
 } Geo_Location;
 
+//! Defines the Geo_Box structure.
+typedef struct {
+    //! The south west corner of the box.
+    Geo_Location southWest;
+    //! The north east corner of the box.
+    Geo_Location northEast;
+} Geo_Box;
+
 //! Defines the Voxel structure.
 typedef struct {
     //! The x component of the voxel.
@@ -67,4 +112,25 @@ typedef struct {
     double z;
 } Voxel;
 
+//! Defines the Query_Options structure, the settings of one query.
+//! Concurrent queries may use different options.
+typedef struct {
+    //! Interpolation between posts.
+    Interpolation_Mode interpolation;
+    //! Dted level queried.
+    Dted_Level level;
+    //! Elevation reported for void posts and missing data, e.g. 0.0 or
+    //! NULL_POST.
+    double nullElevation;
+    //! Answer geolocation queries from the coarser levels where level
+    //! has no coverage or a void post.
+    bool levelFallback;
+    //! Ground resolution needed, in meters: geolocation queries use the
+    //! coarsest level up to level whose posts are at most this far
+    //! apart.  0.0 queries level itself.
+    double resolution;
+    //! Overview answering the queries whose resolution allows one.
+    Overview_Mode overview;
+} Query_Options;
+
 #endif
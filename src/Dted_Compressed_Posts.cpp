@@ -0,0 +1,231 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Resident posts of a Dted cell held compressed.
+//
+//********************************************************************
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "Dted_Compressed_Posts.h"
+
+namespace {
+
+struct Cached_Block {
+    unsigned long long owner;
+    int block;
+    short posts[Dted_Compressed_Posts::BLOCK_SIZE
+            * Dted_Compressed_Posts::BLOCK_SIZE];
+};
+
+struct Block_Cache {
+    Block_Cache() {
+        for (int i = 0; i < Dted_Compressed_Posts::CACHE_BLOCKS; i++)
+            blocks[i].owner = 0;
+    }
+
+    Cached_Block blocks[Dted_Compressed_Posts::CACHE_BLOCKS];
+};
+
+boost::thread_specific_ptr<Block_Cache> blockCache;
+
+//! Owner 0 marks an empty cache entry.
+boost::atomic<unsigned long long> nextOwner(1);
+
+inline unsigned int Zig_Zag(int value) {
+    return (value < 0) ? ((unsigned int) (-value) * 2 - 1) :
+            (unsigned int) value * 2;
+}
+
+inline int Un_Zig_Zag(unsigned int value) {
+    return (value & 1) ? -(int) ((value + 1) / 2) : (int) (value / 2);
+}
+
+//! Plane prediction of post (x, y) of a block from decoded neighbours.
+inline int Predict(const short* posts, int stride, int x, int y) {
+    if (x == 0)
+        return posts[y - 1];
+
+    if (y == 0)
+        return posts[(x - 1) * stride];
+
+    return posts[(x - 1) * stride + y] + posts[x * stride + y - 1]
+            - posts[(x - 1) * stride + y - 1];
+}
+
+}
+
+Dted_Compressed_Posts::Dted_Compressed_Posts(const short* posts,
+        int numLonLines, int numLatPoints) :
+        numLonLines(numLonLines),
+        numLatPoints(numLatPoints),
+        blocksX((numLonLines + BLOCK_SIZE - 1) / BLOCK_SIZE),
+        blocksY((numLatPoints + BLOCK_SIZE - 1) / BLOCK_SIZE),
+        owner(nextOwner.fetch_add(1)) {
+    int numBlocks = blocksX * blocksY;
+
+    blockOffsets.resize(numBlocks);
+    blockWidths.resize(numBlocks);
+    blockFirstPosts.resize(numBlocks);
+
+    for (int block = 0; block < numBlocks; block++)
+        Encode_Block(posts, block);
+
+    // Slack for the 64 bit reads of the decoder.
+    blockData.resize(blockData.size() + sizeof(unsigned long long), 0);
+}
+
+void Dted_Compressed_Posts::Encode_Block(const short* posts, int block) {
+    int x0 = (block / blocksY) * BLOCK_SIZE;
+    int y0 = (block % blocksY) * BLOCK_SIZE;
+    int width = min((int) BLOCK_SIZE, numLonLines - x0);
+    int height = min((int) BLOCK_SIZE, numLatPoints - y0);
+
+    // Gather the block with the cache's stride.
+    short local[BLOCK_SIZE * BLOCK_SIZE];
+
+    for (int x = 0; x < width; x++)
+        memcpy(&local[x * BLOCK_SIZE],
+                &posts[(size_t) (x0 + x) * numLatPoints + y0],
+                height * sizeof(short));
+
+    unsigned int residuals[BLOCK_SIZE * BLOCK_SIZE];
+    unsigned int maxResidual = 0;
+    int count = 0;
+
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if ((x == 0) && (y == 0))
+                continue;
+
+            unsigned int residual = Zig_Zag(
+                    local[x * BLOCK_SIZE + y]
+                            - Predict(local, BLOCK_SIZE, x, y));
+
+            residuals[count++] = residual;
+
+            if (residual > maxResidual)
+                maxResidual = residual;
+        }
+    }
+
+    int bits = 0;
+
+    while ((bits < 32) && ((maxResidual >> bits) != 0))
+        bits++;
+
+    blockOffsets[block] = blockData.size();
+    blockWidths[block] = bits;
+    blockFirstPosts[block] = local[0];
+
+    // Pack least significant bit first; a uniform block takes no bytes.
+    unsigned long long accumulator = 0;
+    int pending = 0;
+
+    for (int i = 0; (i < count) && (bits > 0); i++) {
+        accumulator |= (unsigned long long) residuals[i] << pending;
+        pending += bits;
+
+        while (pending >= 8) {
+            blockData.push_back((unsigned char) accumulator);
+            accumulator >>= 8;
+            pending -= 8;
+        }
+    }
+
+    if (pending > 0)
+        blockData.push_back((unsigned char) accumulator);
+}
+
+void Dted_Compressed_Posts::Decode_Block(int block, short* decoded) const {
+    int x0 = (block / blocksY) * BLOCK_SIZE;
+    int y0 = (block % blocksY) * BLOCK_SIZE;
+    int width = min((int) BLOCK_SIZE, numLonLines - x0);
+    int height = min((int) BLOCK_SIZE, numLatPoints - y0);
+    int bits = blockWidths[block];
+    unsigned long long mask = (1ULL << bits) - 1;
+
+    const unsigned char* data = &blockData[blockOffsets[block]];
+    size_t bitPosition = 0;
+
+    decoded[0] = blockFirstPosts[block];
+
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if ((x == 0) && (y == 0))
+                continue;
+
+            unsigned int residual = 0;
+
+            if (bits > 0) {
+                unsigned long long word;
+                memcpy(&word, data + bitPosition / 8, sizeof(word));
+                residual = (word >> (bitPosition % 8)) & mask;
+                bitPosition += bits;
+            }
+
+            decoded[x * BLOCK_SIZE + y] = Predict(decoded, BLOCK_SIZE, x, y)
+                    + Un_Zig_Zag(residual);
+        }
+    }
+}
+
+const short* Dted_Compressed_Posts::Decoded_Block(int block) const {
+    Block_Cache* cache = blockCache.get();
+
+    if (cache == NULL) {
+        cache = new Block_Cache();
+        blockCache.reset(cache);
+    }
+
+    Cached_Block& cached = cache->blocks[(block ^ (owner * 7))
+            & (CACHE_BLOCKS - 1)];
+
+    if ((cached.owner != owner) || (cached.block != block)) {
+        Decode_Block(block, cached.posts);
+        cached.owner = owner;
+        cached.block = block;
+    }
+
+    return cached.posts;
+}
+
+short Dted_Compressed_Posts::Get_Post(int x, int y) const {
+    const short* decoded = Decoded_Block(
+            (x / BLOCK_SIZE) * blocksY + y / BLOCK_SIZE);
+
+    return decoded[(x % BLOCK_SIZE) * BLOCK_SIZE + y % BLOCK_SIZE];
+}
+
+void Dted_Compressed_Posts::Decode_All(short* posts) const {
+    short decoded[BLOCK_SIZE * BLOCK_SIZE];
+
+    for (int block = 0; block < blocksX * blocksY; block++) {
+        int x0 = (block / blocksY) * BLOCK_SIZE;
+        int y0 = (block % blocksY) * BLOCK_SIZE;
+        int width = min((int) BLOCK_SIZE, numLonLines - x0);
+        int height = min((int) BLOCK_SIZE, numLatPoints - y0);
+
+        Decode_Block(block, decoded);
+
+        for (int x = 0; x < width; x++)
+            memcpy(&posts[(size_t) (x0 + x) * numLatPoints + y0],
+                    &decoded[x * BLOCK_SIZE], height * sizeof(short));
+    }
+}
+
+size_t Dted_Compressed_Posts::Get_Compressed_Size() const {
+    return blockData.size() + blockOffsets.size() * sizeof(unsigned int)
+            + blockWidths.size() + blockFirstPosts.size() * sizeof(short);
+}
@@ -0,0 +1,81 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Resident posts of a Dted cell held compressed.  The
+//               posts are split into BLOCK_SIZE x BLOCK_SIZE blocks which
+//               are coded independently: each post is predicted from its
+//               west, south and south west neighbours (plane prediction)
+//               and the zig-zagged residuals are bit packed at the width
+//               of the block's largest residual.  A lookup decodes one
+//               block into a small per-thread cache of decoded blocks.
+//
+//********************************************************************
+
+#ifndef Dted_Compressed_Posts_H
+#define Dted_Compressed_Posts_H
+
+#include <stddef.h>
+
+#include <vector>
+
+using namespace std;
+
+class Dted_Compressed_Posts {
+public:
+
+    enum {
+        BLOCK_SIZE = 32,  // Posts per block side
+        CACHE_BLOCKS = 16 // Decoded blocks cached per thread
+    };
+
+    /*! Compress posts laid out one longitude line after the other.
+     @param posts numLonLines * numLatPoints posts.
+     */
+    Dted_Compressed_Posts(const short* posts, int numLonLines,
+            int numLatPoints);
+
+    //! Return the post of longitude line x, latitude point y.
+    short Get_Post(int x, int y) const;
+
+    //! Decode every post into posts (numLonLines * numLatPoints).
+    void Decode_All(short* posts) const;
+
+    //! Bytes held by the compressed posts.
+    size_t Get_Compressed_Size() const;
+
+private:
+
+    Dted_Compressed_Posts(const Dted_Compressed_Posts&);
+    const Dted_Compressed_Posts& operator=(const Dted_Compressed_Posts&);
+
+    //! Return the decoded posts of a block, decoding it if not cached.
+    //! Post (x, y) of the block is at [x * BLOCK_SIZE + y].
+    const short* Decoded_Block(int block) const;
+
+    void Encode_Block(const short* posts, int block);
+    void Decode_Block(int block, short* decoded) const;
+
+    int numLonLines;
+    int numLatPoints;
+    int blocksX;
+    int blocksY;
+
+    //! Identifies the posts in the per-thread caches.
+    unsigned long long owner;
+
+    //! Per block: offset of its bits in blockData, residual width and
+    //! value of the first post.
+    vector<unsigned int> blockOffsets;
+    vector<unsigned char> blockWidths;
+    vector<short> blockFirstPosts;
+
+    vector<unsigned char> blockData;
+};
+
+#endif
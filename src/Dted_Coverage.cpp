@@ -0,0 +1,59 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Bitmap of the one degree cells a Dted directory holds.
+//
+//********************************************************************
+
+#include <vector>
+
+#include "Dted_Coverage.h"
+
+Dted_Coverage::Dted_Coverage() {
+    Clear();
+}
+
+void Dted_Coverage::Build(Dted_Directory& directory) {
+    vector<unsigned long long> covered(NUM_WORDS, 0);
+    Dted_Cell_Path_Entry dtedCellPathEntry;
+
+    directory.QueryReset();
+
+    while (directory.Query(dtedCellPathEntry)) {
+        if (!Dted_Cell_Grid::Is_Valid(dtedCellPathEntry.latitude,
+                dtedCellPathEntry.longitude))
+            continue;
+
+        int cell = Cell_Index(dtedCellPathEntry.latitude,
+                dtedCellPathEntry.longitude);
+
+        covered[cell / 64] |= 1ULL << (cell % 64);
+    }
+
+    for (int i = 0; i < NUM_WORDS; i++)
+        words[i].store(covered[i], boost::memory_order_relaxed);
+}
+
+void Dted_Coverage::Clear() {
+    for (int i = 0; i < NUM_WORDS; i++)
+        words[i].store(0, boost::memory_order_relaxed);
+}
+
+int Dted_Coverage::Count() const {
+    int count = 0;
+
+    for (int i = 0; i < NUM_WORDS; i++) {
+        unsigned long long word = words[i].load(boost::memory_order_relaxed);
+
+        for (; word != 0; word &= word - 1)
+            count++;
+    }
+
+    return count;
+}
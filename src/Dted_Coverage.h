@@ -0,0 +1,85 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Bitmap of the one degree cells a Dted directory holds,
+//               one bit per cell of the globe.  Queries test it without
+//               a lock to skip levels and cells that have no data,
+//               instead of missing in the directory each time.
+//
+//********************************************************************
+
+#ifndef Dted_Coverage_H
+#define Dted_Coverage_H
+
+#include <boost/atomic.hpp>
+
+#include "Dted_Cell_Grid.h"
+#include "Dted_Common.h"
+#include "Dted_Directory.h"
+
+class Dted_Coverage {
+public:
+
+    enum {
+        NUM_CELLS = Dted_Cell_Grid::NUM_PARALLELS
+                * Dted_Cell_Grid::NUM_MERIDIANS,
+        NUM_WORDS = (NUM_CELLS + 63) / 64
+    };
+
+    //! Starts empty.
+    Dted_Coverage();
+
+    /*! Replace the bitmap by the cells of a directory.  Queries running
+     meanwhile see each word either before or after the rebuild.
+     The caller serializes access to the directory.
+     */
+    void Build(Dted_Directory& directory);
+
+    //! Remove every cell.
+    void Clear();
+
+    //! Returns true if the cell with this south west corner is covered.
+    inline bool Covers(short latitude, short longitude) const {
+        if (!Dted_Cell_Grid::Is_Valid(latitude, longitude))
+            return false;
+
+        int cell = Cell_Index(latitude, longitude);
+
+        return (words[cell / 64].load(boost::memory_order_relaxed)
+                >> (cell % 64)) & 1;
+    }
+
+    //! Returns true if the cell holding the location is covered.
+    inline bool Covers(const Geo_Location& geoLoc) const {
+        short latitude;
+        short longitude;
+
+        Dted_Cell_Grid::Cell_Corner(geoLoc, latitude, longitude);
+
+        return Covers(latitude, longitude);
+    }
+
+    //! Number of covered cells.
+    int Count() const;
+
+private:
+
+    Dted_Coverage(const Dted_Coverage&);
+    const Dted_Coverage& operator=(const Dted_Coverage&);
+
+    static int Cell_Index(short latitude, short longitude) {
+        return (latitude + Dted_Cell_Grid::NUM_PARALLELS / 2)
+                * Dted_Cell_Grid::NUM_MERIDIANS
+                + (longitude + Dted_Cell_Grid::NUM_MERIDIANS / 2);
+    }
+
+    boost::atomic<unsigned long long> words[NUM_WORDS];
+};
+
+#endif
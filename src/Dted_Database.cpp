@@ -12,20 +12,56 @@
 //
 //********************************************************************
 
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include <boost/bind/bind.hpp>
+
+#include "Dted_Archive.h"
 #include "Dted_Database.h"
 #include "Dted_Cell_Path_Entry.h"
 #include "Dted_Cell.h"
-
-Dted_Database::Dted_Database() {
-    dted1CellSet.clear();
-    dted2CellSet.clear();
-    dted1_dir.Clear_Dted_Directory();
-    dted2_dir.Clear_Dted_Directory();
+#include "Dted_Numa.h"
+#include "Dted_Packed_Format.h"
+#include "Dted_Snapshot_Format.h"
+
+Dted_Database::Dted_Database() :
+        pageCache(cellEpoch, (size_t) 256 << 20),
+        cellLoader(
+                boost::bind(&Dted_Database::Load_Requested_Cell, this,
+                        boost::placeholders::_1),
+                boost::bind(&Dted_Database::Load_Requested_Cells, this,
+                        boost::placeholders::_1, boost::placeholders::_2)) {
+    levelStores[LEVEL_0] = &dted0Store;
+    levelStores[LEVEL_1] = &dted1Store;
+    levelStores[LEVEL_2] = &dted2Store;
 
     // Default to memory access
     accessMethod = MEMORY_ACCESS;
     dtedLevel = LEVEL_1;
     bilinearInterpActive = false;
+    levelFallbackActive = false;
+    queryResolution = 0.0;
+    overviewLevels = 0;
+    overviewModes = OVERVIEW_AVERAGE;
+    realTimeActive = false;
+    recordingActive = false;
+    tileArenaActive = false;
+    tileArenaHugeTlb = false;
+    numaPlacement = NUMA_NONE;
+
+    memoryBudget = (size_t) 512 << 20;
+    promoteThreshold = DEFAULT_PROMOTE_THRESHOLD;
+    residentEstimate = 0;
+    agedUntil = Now_Ms();
 
     prevFailedCellPathEntry.latitude = -32767;
     prevFailedCellPathEntry.longitude = -32767;
@@ -33,37 +69,33 @@ Dted_Database::Dted_Database() {
     debug = false;
 }
 
-void Dted_Database::Clear_Database() {
-    Dted_Cell_Set::const_iterator it = dted1CellSet.begin();
+Dted_Database::~Dted_Database() {
+    Clear_Database();
+}
 
-    while (it != dted1CellSet.end()) {
-        Dted_Cell* dtedCellPtr = (Dted_Cell*) *it;
-        delete dtedCellPtr;
+void Dted_Database::Clear_Database() {
+    vector<Dted_Cell*> cells;
 
-        it++;
-    }
+    // Background loads would otherwise publish into the cleared grids.
+    cellLoader.Cancel_All();
 
-    it = dted2CellSet.begin();
+    {
+        boost::mutex::scoped_lock lock(loadMutex);
 
-    while (it != dted2CellSet.end()) {
-        Dted_Cell* dtedCellPtr = (Dted_Cell*) *it;
-        delete dtedCellPtr;
+        for (int l = 0; l < NUM_LEVELS; l++) {
+            levelStores[l]->Cell_Grid().Clear(cells);
+            levelStores[l]->Directory().Clear_Dted_Directory();
+            levelStores[l]->Coverage().Clear();
+        }
 
-        it++;
+        prevFailedCellPathEntry.latitude = -32767;
+        prevFailedCellPathEntry.longitude = -32767;
     }
 
-    dted1CellSet.clear();
-    dted2CellSet.clear();
-
-    dted1_dir.Clear_Dted_Directory();
-    dted2_dir.Clear_Dted_Directory();
-
-    prevCellItDted1 = (Dted_Cell_Set::const_iterator) NULL;
-    prevCellItDted2 = (Dted_Cell_Set::const_iterator) NULL;
-
-    prevFailedCellPathEntry.latitude = -32767;
-    prevFailedCellPathEntry.longitude = -32767;
+    for (size_t i = 0; i < cells.size(); i++)
+        cellEpoch.Retire(cells[i], Dted_Epoch::Delete_Object<Dted_Cell>);
 
+    cellEpoch.Collect();
 }
 
 void Dted_Database::Set_Bilinear_Interp_Active(bool newState) {
@@ -71,470 +103,1724 @@ void Dted_Database::Set_Bilinear_Interp_Active(bool newState) {
 }
 
 double Dted_Database::Get_Geo_Elev(Geo_Location geoLoc) {
-    double returnElev = 0.0;
+    double returnElev;
 
-    if (dtedLevel == LEVEL_1)
-        returnElev = Get_Geo_Elev_Dted1(geoLoc);
-    else if (dtedLevel == LEVEL_2)
-        returnElev = Get_Geo_Elev_Dted2(geoLoc);
+    Get_Geo_Elev(geoLoc, Get_Query_Options(), returnElev);
 
     return returnElev;
 }
 
 double Dted_Database::Get_Post_Elev(Geo_Location geoLoc, Voxel pointLoc) {
-    double returnElev = 0.0;
+    double returnElev;
 
-    if (dtedLevel == LEVEL_1)
-        returnElev = Get_Post_Elev_Dted1(geoLoc, pointLoc);
-    else if (dtedLevel == LEVEL_2)
-        returnElev = Get_Post_Elev_Dted2(geoLoc, pointLoc);
+    Get_Post_Elev(geoLoc, pointLoc, Get_Query_Options(), returnElev);
 
     return returnElev;
 }
 
-double Dted_Database::Get_Geo_Elev_Dted1(Geo_Location geoLoc) {
-    bool found = false;
+Query_Status Dted_Database::Get_Geo_Elev(Geo_Location geoLoc,
+        double& elevation) {
+    return Get_Geo_Elev(geoLoc, Get_Query_Options(), elevation);
+}
 
-    double elevHeight = 0.0;
-    Dted_Cell* dtedCellPtr = NULL;
+Query_Status Dted_Database::Get_Post_Elev(Geo_Location geoLoc,
+        Voxel pointLoc, double& elevation) {
+    return Get_Post_Elev(geoLoc, pointLoc, Get_Query_Options(), elevation);
+}
 
-    Dted_Cell_Set::const_iterator it;
+Query_Status Dted_Database::Get_Geo_Elev(Geo_Location geoLoc,
+        const Query_Options& options, double& elevation) {
+    if (options.resolution > 0.0) {
+        Dted_Level level;
 
-    Dted_Cell_Path_Entry dtedCellPathEntry;
+        return Get_Lod_Geo_Elev(geoLoc, options, elevation, level);
+    }
 
-    dtedCellPathEntry.latitude = (short int) geoLoc.lat;
+    if (options.levelFallback) {
+        Dted_Level level;
 
-    if (geoLoc.lat < 0.0)
-        dtedCellPathEntry.latitude -= 1;
+        return Get_Best_Geo_Elev(geoLoc, options, elevation, level);
+    }
 
-    dtedCellPathEntry.longitude = (short int) geoLoc.lon;
+    if (realTimeActive)
+        return Get_Resident_Geo_Elev(geoLoc, options, elevation);
 
-    if (geoLoc.lon < 0)
-        dtedCellPathEntry.longitude -= 1;
+    elevation = options.nullElevation;
 
-    if (dtedCellPathEntry == prevFailedCellPathEntry) {
-        elevHeight = NULL_POST;
-    } else   // Normal: not the same cell path as the previous failed position
-    {
-        // Attempt to use last found cell to avoid re-searching through all cells
-        if (prevCellItDted1 != (Dted_Cell_Set::const_iterator) NULL) {
-            it = prevCellItDted1;
-            dtedCellPtr = (Dted_Cell*) *it;
-            found = dtedCellPtr->covers(geoLoc);
-        }
+    if (!Is_Valid_Location(geoLoc))
+        return QUERY_OUT_OF_RANGE;
+
+    Dted_Level_Store* store = Store(options.level);
+
+    if (store == NULL)
+        return QUERY_NO_COVERAGE;
+
+    return Get_Level_Geo_Elev(*store, geoLoc, options.interpolation,
+            elevation);
+}
 
-        it = dted1CellSet.begin();
+Query_Status Dted_Database::Get_Post_Elev(Geo_Location geoLoc,
+        Voxel pointLoc, const Query_Options& options, double& elevation) {
+    if (realTimeActive)
+        return Get_Resident_Post_Elev(geoLoc, pointLoc, options, elevation);
 
-        // Search for cell that provides coverage
-        while ((it != dted1CellSet.end()) && (found == false)) {
-            dtedCellPtr = (Dted_Cell*) *it;
+    elevation = options.nullElevation;
 
-            found = dtedCellPtr->covers(geoLoc);
+    if (!Is_Valid_Location(geoLoc))
+        return QUERY_OUT_OF_RANGE;
 
-            if (found)
-                prevCellItDted1 = it;
+    Dted_Level_Store* store = Store(options.level);
 
-            it++;
+    if (store == NULL)
+        return QUERY_NO_COVERAGE;
+
+    return Get_Level_Post_Elev(*store, geoLoc, pointLoc, elevation);
+}
+
+Query_Options Dted_Database::Get_Query_Options() const {
+    Query_Options options;
+    options.interpolation =
+            bilinearInterpActive ? BILINEAR : NEAREST_NEIGHBOR;
+    options.level = dtedLevel;
+    options.nullElevation = 0.0;
+    options.levelFallback = levelFallbackActive;
+    options.resolution = queryResolution;
+    // The first mode built.
+    options.overview = (Overview_Mode) (overviewModes & (~overviewModes + 1));
+
+    if (options.overview == 0)
+        options.overview = OVERVIEW_AVERAGE;
+
+    return options;
+}
+
+Query_Status Dted_Database::Get_Best_Geo_Elev(Geo_Location geoLoc,
+        const Query_Options& options, double& elevation, Dted_Level& level) {
+    elevation = options.nullElevation;
+    level = options.level;
+
+    if (!Is_Valid_Location(geoLoc))
+        return QUERY_OUT_OF_RANGE;
+
+    Query_Options levelOptions = options;
+    levelOptions.levelFallback = false;
+    levelOptions.resolution = 0.0;
+
+    Query_Status status = QUERY_NO_COVERAGE;
+
+    for (int l = options.level; l >= LEVEL_0; l--) {
+        const Dted_Coverage* coverage = Coverage((Dted_Level) l);
+
+        if ((coverage == NULL) || !coverage->Covers(geoLoc))
+            continue;
+
+        levelOptions.level = (Dted_Level) l;
+
+        Query_Status levelStatus = Get_Geo_Elev(geoLoc, levelOptions,
+                elevation);
+
+        if (levelStatus == QUERY_OK) {
+            level = levelOptions.level;
+            return QUERY_OK;
         }
 
-        if (found) {
-            dtedCellPtr->setBilinearInterpActive(bilinearInterpActive);
+        // Report why the finest covering level failed.
+        if (status == QUERY_NO_COVERAGE)
+            status = levelStatus;
+    }
 
-            if (accessMethod == MEMORY_ACCESS) {
-                elevHeight = dtedCellPtr->getHeightAboveMSL(geoLoc);
-            } else // Using disk access
-            {
-                elevHeight = dtedCellPtr->getHeightAboveMSLFromDisk(geoLoc);
-            }
-        } else {
-            // Load cell from file.
-            if (dted1_dir.Retrieve_Dted_Entry(dtedCellPathEntry)) {
-                Dted_Cell* dtedCellPtr = new Dted_Cell(
-                        dtedCellPathEntry.cellPath);
+    elevation = options.nullElevation;
 
-                if (accessMethod == MEMORY_ACCESS)
-                    dtedCellPtr->loadCellFromDisk();
+    return status;
+}
 
-                dted1CellSet.insert(dtedCellPtr);
+void Dted_Database::Set_Level_Fallback_Active(bool newState) {
+    levelFallbackActive = newState;
+}
 
-                // Call the method again.  This time the cell will be in the database.
-                return Get_Geo_Elev_Dted1(geoLoc);
-            } else {
-                elevHeight = NULL_POST;
-                prevFailedCellPathEntry = dtedCellPathEntry;
-            }
+Query_Status Dted_Database::Get_Lod_Geo_Elev(Geo_Location geoLoc,
+        const Query_Options& options, double& elevation, Dted_Level& level) {
+    elevation = options.nullElevation;
+    level = options.level;
+
+    if (!Is_Valid_Location(geoLoc))
+        return QUERY_OUT_OF_RANGE;
+
+    Query_Options levelOptions = options;
+    levelOptions.levelFallback = false;
+    levelOptions.resolution = 0.0;
+
+    Query_Status status = QUERY_NO_COVERAGE;
+
+    for (int l = LEVEL_0; l <= options.level; l++) {
+        Dted_Level_Store* store = Store((Dted_Level) l);
+
+        if ((store == NULL) || !store->Coverage().Covers(geoLoc))
+            continue;
+
+        // Too coarse for the resolution.
+        if ((l != options.level)
+                && (store->Get_Post_Spacing() > options.resolution))
+            continue;
+
+        levelOptions.level = (Dted_Level) l;
+
+        int overviewLevel = Overview_Level(*store, options.resolution);
+        Query_Status levelStatus =
+                (overviewLevel > 0) ?
+                        Get_Overview_Geo_Elev(*store, geoLoc, overviewLevel,
+                                levelOptions, elevation) :
+                        Get_Geo_Elev(geoLoc, levelOptions, elevation);
+
+        if (levelStatus == QUERY_OK) {
+            level = levelOptions.level;
+            return QUERY_OK;
         }
+
+        if (status == QUERY_NO_COVERAGE)
+            status = levelStatus;
     }
 
-    if (elevHeight == NULL_POST) {
-        elevHeight = 0.0;
+    if (options.levelFallback) {
+        levelOptions.level = options.level;
+
+        return Get_Best_Geo_Elev(geoLoc, levelOptions, elevation, level);
     }
 
-    return elevHeight;
+    elevation = options.nullElevation;
+
+    return status;
 }
 
-double Dted_Database::Get_Post_Elev_Dted1(Geo_Location geoLoc, Voxel pointLoc) {
-    bool found = false;
-    double elevHeight = 0.0;
-    Dted_Cell* dtedCellPtr = NULL;
+void Dted_Database::Set_Query_Resolution(double meters) {
+    queryResolution = meters;
+}
 
-    // Memory Access
-    Dted_Cell_Set::const_iterator it;
+Query_Status Dted_Database::Get_Region_Max(const Geo_Box& box,
+        double& elevation) {
+    return Get_Region_Post(box, Get_Query_Options(), true, elevation);
+}
 
-    Dted_Cell_Path_Entry dtedCellPathEntry;
+Query_Status Dted_Database::Get_Region_Max(const Geo_Box& box,
+        const Query_Options& options, double& elevation) {
+    return Get_Region_Post(box, options, true, elevation);
+}
+
+Query_Status Dted_Database::Get_Region_Min(const Geo_Box& box,
+        double& elevation) {
+    return Get_Region_Post(box, Get_Query_Options(), false, elevation);
+}
 
-    dtedCellPathEntry.latitude = (short int) geoLoc.lat;
+Query_Status Dted_Database::Get_Region_Min(const Geo_Box& box,
+        const Query_Options& options, double& elevation) {
+    return Get_Region_Post(box, options, false, elevation);
+}
 
-    if (dtedCellPathEntry.latitude < 0)
-        dtedCellPathEntry.latitude -= 1;
+Query_Status Dted_Database::Get_Region_Post(const Geo_Box& box,
+        const Query_Options& options, bool findMax, double& elevation) {
+    // Posts this close to the box are on its edge.
+    const double EDGE_TOLERANCE = 1e-6;
 
-    dtedCellPathEntry.longitude = (short int) geoLoc.lon;
+    elevation = options.nullElevation;
 
-    if (dtedCellPathEntry.longitude < 0)
-        dtedCellPathEntry.longitude -= 1;
+    if (!Is_Valid_Location(box.southWest) || !Is_Valid_Location(box.northEast)
+            || (box.southWest.lat > box.northEast.lat)
+            || (box.southWest.lon > box.northEast.lon))
+        return QUERY_OUT_OF_RANGE;
 
-    if (dtedCellPathEntry == prevFailedCellPathEntry) {
-        elevHeight = NULL_POST;
-    } else   // Normal: not the same cell path as the previous failed position
-    {
-        // Attempt to use last found cell to avoid re-searching through all cells
-        if (prevCellItDted1 != Dted_Cell_Set::const_iterator(NULL)) {
-            it = prevCellItDted1;
-            dtedCellPtr = (Dted_Cell*) *it;
-            found = dtedCellPtr->covers(geoLoc);
-        }
+    Dted_Level_Store* store = Store(options.level);
 
-        it = dted1CellSet.begin();
+    if (store == NULL)
+        return QUERY_NO_COVERAGE;
 
-        // Search for cell that provides coverage
-        while ((it != dted1CellSet.end()) && (found == false)) {
-            dtedCellPtr = (Dted_Cell*) *it;
+    short minLatitude = (short) floor(box.southWest.lat);
+    short minLongitude = (short) floor(box.southWest.lon);
+    short maxLatitude = (short) floor(box.northEast.lat);
+    short maxLongitude = (short) floor(box.northEast.lon);
 
-            found = dtedCellPtr->covers(geoLoc);
+    Query_Status status = QUERY_NO_COVERAGE;
+    bool notResident = false;
+    bool found = false;
+    short best = 0;
 
-            if (found)
-                prevCellItDted1 = it;
+    Dted_Epoch::Guard guard(cellEpoch);
 
-            it++;
-        }
+    for (short lat = minLatitude; lat <= maxLatitude; lat++) {
+        for (short lon = minLongitude; lon <= maxLongitude; lon++) {
+            if (!store->Coverage().Covers(lat, lon))
+                continue;
 
-        if (found) {
-            if (accessMethod == MEMORY_ACCESS)
-                elevHeight = dtedCellPtr->getPostValue(pointLoc);
-            else
-                // Using disk access
-                elevHeight = dtedCellPtr->getPostValueFromDisk(pointLoc);
-        } else {
-            // Load cell from file
-            if (dted1_dir.Retrieve_Dted_Entry(dtedCellPathEntry)) {
-                Dted_Cell* dtedCellPtr = new Dted_Cell(
-                        dtedCellPathEntry.cellPath);
+            Geo_Location cellCenter;
+            cellCenter.lat = lat + 0.5;
+            cellCenter.lon = lon + 0.5;
 
-                if (accessMethod == MEMORY_ACCESS)
-                    dtedCellPtr->loadCellFromDisk();
+            Dted_Cell* dtedCellPtr = store->Cell_Grid().Find(cellCenter);
 
-                dted1CellSet.insert(dtedCellPtr);
+            // Load cell from file.
+            if ((dtedCellPtr == NULL) && !realTimeActive)
+                dtedCellPtr = Load_Cell(options.level, cellCenter);
+
+            if (realTimeActive
+                    && ((dtedCellPtr == NULL)
+                            || !dtedCellPtr->hasDirectPosts())) {
+                notResident = true;
+                continue;
+            }
+
+            if (dtedCellPtr == NULL)
+                continue;
+
+            if (recordingActive)
+                workingSet.Record(options.level, cellCenter);
+
+            if (!realTimeActive && (dtedCellPtr->getMinMaxTree() == NULL))
+                dtedCellPtr->buildMinMaxTree();
+
+            Geo_Location swCorner = dtedCellPtr->getSwCornerPost();
+            Cell_Size cellSize = dtedCellPtr->getSizeOfElevCell();
+
+            Dted_Min_Max_Tree::Post_Range range;
+            range.x0 = (int) ceil((box.southWest.lon - swCorner.lon)
+                    * (cellSize.lonLines - 1) - EDGE_TOLERANCE);
+            range.x1 = (int) floor((box.northEast.lon - swCorner.lon)
+                    * (cellSize.lonLines - 1) + EDGE_TOLERANCE);
+            range.y0 = (int) ceil((box.southWest.lat - swCorner.lat)
+                    * (cellSize.latPoints - 1) - EDGE_TOLERANCE);
+            range.y1 = (int) floor((box.northEast.lat - swCorner.lat)
+                    * (cellSize.latPoints - 1) + EDGE_TOLERANCE);
+
+            short post;
 
-                // Call the method again.  This time the cell will be in the database.
-                return Get_Post_Elev_Dted1(geoLoc, pointLoc);
+            if (dtedCellPtr->findRegionPost(range, findMax, post)) {
+                if (!found || (findMax ? (post > best) : (post < best)))
+                    best = post;
 
+                found = true;
             } else {
-                elevHeight = NULL_POST;
-                prevFailedCellPathEntry = dtedCellPathEntry;
+                status = QUERY_VOID_POST;
             }
         }
     }
 
-    if (elevHeight == NULL_POST) {
-        elevHeight = 0.0;
-    }
+    if (notResident)
+        return QUERY_NOT_RESIDENT;
+
+    if (!found)
+        return status;
 
-    return elevHeight;
+    elevation = best;
 
+    return QUERY_OK;
 }
 
-double Dted_Database::Get_Geo_Elev_Dted2(Geo_Location geoLoc) {
-    bool found = false;
+void Dted_Database::Set_Overviews(int levels, unsigned int modes) {
+    overviewLevels = min(levels, (int) Dted_Overview::MAX_LEVELS);
+    overviewModes = modes;
+}
+
+int Dted_Database::Overview_Level(const Dted_Level_Store& store,
+        double resolution) const {
+    int overviewLevel = 0;
+
+    while ((overviewLevel < overviewLevels)
+            && (store.Get_Post_Spacing() * (2 << overviewLevel)
+                    <= resolution))
+        overviewLevel++;
+
+    return overviewLevel;
+}
+
+Query_Status Dted_Database::Get_Overview_Geo_Elev(Dted_Level_Store& store,
+        Geo_Location geoLoc, int overviewLevel, const Query_Options& options,
+        double& elevation) {
+    Dted_Level level = store.Get_Level();
     double elevHeight = 0.0;
-    Dted_Cell* dtedCellPtr = NULL;
 
-    // Memory Access
-    Dted_Cell_Set::const_iterator it;
+    {
+        Dted_Epoch::Guard guard(cellEpoch);
 
-    Dted_Cell_Path_Entry dtedCellPathEntry;
+        Dted_Cell* dtedCellPtr = store.Cell_Grid().Find(geoLoc);
 
-    dtedCellPathEntry.latitude = (short int) geoLoc.lat;
+        // Load cell from file.
+        if ((dtedCellPtr == NULL) && !realTimeActive)
+            dtedCellPtr = Load_Cell(level, geoLoc);
 
-    if (dtedCellPathEntry.latitude < 0)
-        dtedCellPathEntry.latitude -= 1;
+        if (dtedCellPtr != NULL) {
+            if (recordingActive)
+                workingSet.Record(level, geoLoc);
 
-    dtedCellPathEntry.longitude = (short int) geoLoc.lon;
+            const Dted_Overview* overview = dtedCellPtr->getOverview();
 
-    if (dtedCellPathEntry.longitude < 0)
-        dtedCellPathEntry.longitude -= 1;
+            // Real-time queries only use overviews already built.
+            if ((overview == NULL) && !realTimeActive)
+                overview = dtedCellPtr->buildOverview(overviewLevels,
+                        overviewModes);
 
-    if (dtedCellPathEntry == prevFailedCellPathEntry) {
-        elevHeight = NULL_POST;
-    } else   // Normal: not the same cell path as the previous failed position
-    {
+            if ((overview != NULL)
+                    && dtedCellPtr->readOverviewHeight(geoLoc,
+                            min(overviewLevel, overview->Get_Level_Count()),
+                            options.overview, options.interpolation,
+                            elevHeight)) {
+                if (elevHeight == NULL_POST)
+                    return QUERY_VOID_POST;
 
-        // Attempt to use last found cell to avoid re-searching through all cells
-        if (prevCellItDted2 != (Dted_Cell_Set::const_iterator) NULL) {
-            it = prevCellItDted2;
-            dtedCellPtr = (Dted_Cell*) *it;
-            found = dtedCellPtr->covers(geoLoc);
+                elevation = elevHeight;
+
+                return QUERY_OK;
+            }
         }
+    }
 
-        it = dted2CellSet.begin();
+    // No overview: answer at full resolution.
+    return Get_Geo_Elev(geoLoc, options, elevation);
+}
 
-        // Search for cell that provides coverage within database
-        while ((it != dted2CellSet.end()) && (found == false)) {
-            dtedCellPtr = (Dted_Cell*) *it;
+bool Dted_Database::Has_Coverage(Dted_Level level, Geo_Location geoLoc) const {
+    const Dted_Coverage* coverage = Coverage(level);
 
-            found = dtedCellPtr->covers(geoLoc);
+    return (coverage != NULL) && coverage->Covers(geoLoc);
+}
 
-            if (found)
-                prevCellItDted2 = it;
+bool Dted_Database::Is_Valid_Location(const Geo_Location& geoLoc) {
+    // Written so that NaN coordinates are invalid.
+    return (geoLoc.lat >= -90.0) && (geoLoc.lat < 90.0)
+            && (geoLoc.lon >= -180.0) && (geoLoc.lon < 180.0);
+}
 
-            it++;
-        }
+Query_Status Dted_Database::Get_Resident_Geo_Elev(Geo_Location geoLoc,
+        double& elevation) {
+    return Get_Resident_Geo_Elev(geoLoc, Get_Query_Options(), elevation);
+}
 
-        if (found) {
-            dtedCellPtr->setBilinearInterpActive(bilinearInterpActive);
+Query_Status Dted_Database::Get_Resident_Post_Elev(Geo_Location geoLoc,
+        Voxel pointLoc, double& elevation) {
+    return Get_Resident_Post_Elev(geoLoc, pointLoc, Get_Query_Options(),
+            elevation);
+}
 
-            if (accessMethod == MEMORY_ACCESS)
-                elevHeight = dtedCellPtr->getHeightAboveMSL(geoLoc);
-            else
-                // Using disk access
-                elevHeight = dtedCellPtr->getHeightAboveMSLFromDisk(geoLoc);
-        } else {
-            // Load cell from file
-            if (dted2_dir.Retrieve_Dted_Entry(dtedCellPathEntry)) {
-                Dted_Cell* dtedCellPtr = new Dted_Cell(
-                        dtedCellPathEntry.cellPath);
+Query_Status Dted_Database::Get_Resident_Geo_Elev(Geo_Location geoLoc,
+        const Query_Options& options, double& elevation) {
+    elevation = options.nullElevation;
 
-                if (accessMethod == MEMORY_ACCESS)
-                    dtedCellPtr->loadCellFromDisk();
+    if (!Is_Valid_Location(geoLoc))
+        return QUERY_OUT_OF_RANGE;
 
-                dted2CellSet.insert(dtedCellPtr);
+    Dted_Cell_Grid* cellGrid = Cell_Grid(options.level);
 
-                // Call the method again.  This time the cell will be in the database.
-                return Get_Geo_Elev_Dted2(geoLoc);
-            } else {
-                elevHeight = NULL_POST;
-                prevFailedCellPathEntry = dtedCellPathEntry;
-            }
-        }
+    if (cellGrid == NULL)
+        return QUERY_NOT_RESIDENT;
 
-    }   // prevFailedCellPathEntry
+    // Never wait for a reader slot; see Register_Real_Time_Thread().
+    Dted_Epoch::Guard guard(cellEpoch, false);
 
-    if (elevHeight == NULL_POST) {
-        elevHeight = 0.0;
-    }
+    if (!guard.Is_Entered())
+        return QUERY_NOT_RESIDENT;
+
+    Dted_Cell* dtedCellPtr = cellGrid->Find(geoLoc);
 
-    return elevHeight;
+    if ((dtedCellPtr == NULL) || !dtedCellPtr->hasDirectPosts())
+        return Has_Coverage(options.level, geoLoc) ?
+                QUERY_NOT_RESIDENT : QUERY_NO_COVERAGE;
 
+    double elevHeight = dtedCellPtr->getHeightAboveMSL(geoLoc,
+            options.interpolation);
+
+    if (elevHeight == NULL_POST)
+        return QUERY_VOID_POST;
+
+    elevation = elevHeight;
+
+    return QUERY_OK;
 }
 
-double Dted_Database::Get_Post_Elev_Dted2(Geo_Location geoLoc, Voxel pointLoc) {
-    bool found = false;
-    double elevHeight = 0.0;
-    Dted_Cell* dtedCellPtr = NULL;
+Query_Status Dted_Database::Get_Resident_Post_Elev(Geo_Location geoLoc,
+        Voxel pointLoc, const Query_Options& options, double& elevation) {
+    elevation = options.nullElevation;
 
-    // Memory Access
-    Dted_Cell_Set::const_iterator it;
+    if (!Is_Valid_Location(geoLoc))
+        return QUERY_OUT_OF_RANGE;
 
-    Dted_Cell_Path_Entry dtedCellPathEntry;
+    Dted_Cell_Grid* cellGrid = Cell_Grid(options.level);
 
-    dtedCellPathEntry.latitude = (short int) geoLoc.lat;
+    if (cellGrid == NULL)
+        return QUERY_NOT_RESIDENT;
 
-    if (dtedCellPathEntry.latitude < 0)
-        dtedCellPathEntry.latitude -= 1;
+    // Never wait for a reader slot; see Register_Real_Time_Thread().
+    Dted_Epoch::Guard guard(cellEpoch, false);
 
-    dtedCellPathEntry.longitude = (short int) geoLoc.lon;
+    if (!guard.Is_Entered())
+        return QUERY_NOT_RESIDENT;
 
-    if (dtedCellPathEntry.longitude < 0)
-        dtedCellPathEntry.longitude -= 1;
+    Dted_Cell* dtedCellPtr = cellGrid->Find(geoLoc);
 
-    if (dtedCellPathEntry == prevFailedCellPathEntry) {
-        elevHeight = NULL_POST;
-    } else   // Normal: not the same cell path as the previous failed position
-    {
+    if ((dtedCellPtr == NULL) || !dtedCellPtr->hasDirectPosts())
+        return Has_Coverage(options.level, geoLoc) ?
+                QUERY_NOT_RESIDENT : QUERY_NO_COVERAGE;
 
-        // Attempt to use last found cell to avoid re-searching through all cells
-        if (prevCellItDted2 != (Dted_Cell_Set::const_iterator) NULL) {
-            it = prevCellItDted2;
-            dtedCellPtr = (Dted_Cell*) *it;
-            found = dtedCellPtr->covers(geoLoc);
-        }
+    double elevHeight;
 
-        it = dted2CellSet.begin();
+    if (!dtedCellPtr->readPostValue(pointLoc, elevHeight))
+        return QUERY_OUT_OF_RANGE;
 
-        // Search for cell that provides coverage
-        while ((it != dted2CellSet.end()) && (found == false)) {
-            dtedCellPtr = (Dted_Cell*) *it;
+    if (elevHeight == NULL_POST)
+        return QUERY_VOID_POST;
 
-            found = dtedCellPtr->covers(geoLoc);
+    elevation = elevHeight;
 
-            if (found)
-                prevCellItDted2 = it;
+    return QUERY_OK;
+}
 
-            it++;
-        }
+bool Dted_Database::Pin_Region(const Geo_Box& box, Dted_Level level,
+        bool lockMemory) {
+    if (Cell_Grid(level) == NULL)
+        return false;
 
-        if (found) {
-            if (accessMethod == MEMORY_ACCESS)
-                elevHeight = dtedCellPtr->getPostValue(pointLoc);
-            else
-                // Using disk access
-                elevHeight = dtedCellPtr->getPostValueFromDisk(pointLoc);
-        } else {
-            // Load cell from file
-            if (dted2_dir.Retrieve_Dted_Entry(dtedCellPathEntry)) {
-                Dted_Cell* dtedCellPtr = new Dted_Cell(
-                        dtedCellPathEntry.cellPath);
+    if (!Is_Valid_Location(box.southWest) || !Is_Valid_Location(box.northEast)
+            || (box.southWest.lat > box.northEast.lat)
+            || (box.southWest.lon > box.northEast.lon)) {
+        cerr << "ERROR: Invalid pin region" << endl;
+        return false;
+    }
 
-                if (accessMethod == MEMORY_ACCESS)
-                    dtedCellPtr->loadCellFromDisk();
+    short minLatitude = (short) floor(box.southWest.lat);
+    short minLongitude = (short) floor(box.southWest.lon);
+    short maxLatitude = (short) floor(box.northEast.lat);
+    short maxLongitude = (short) floor(box.northEast.lon);
 
-                dted2CellSet.insert(dtedCellPtr);
+    bool pinned = true;
 
-                // Call the method again.  This time the cell will be in the database.
-                return Get_Post_Elev_Dted2(geoLoc, pointLoc);
-            } else {
-                elevHeight = NULL_POST;
-                prevFailedCellPathEntry = dtedCellPathEntry;
+    for (short lat = minLatitude; lat <= maxLatitude; lat++) {
+        for (short lon = minLongitude; lon <= maxLongitude; lon++) {
+            if (!Pin_Cell(level, lat, lon, lockMemory)) {
+                cerr << "ERROR: Can not pin dted cell (" << lat << ", "
+                        << lon << ")" << endl;
+                pinned = false;
             }
         }
     }
 
-    if (elevHeight == NULL_POST) {
-        elevHeight = 0.0;
+    return pinned;
+}
+
+bool Dted_Database::Pin_Cell(Dted_Level level, short latitude,
+        short longitude, bool lockMemory) {
+    Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+
+    Dted_Cell_Path_Entry dtedCellPathEntry;
+    dtedCellPathEntry.latitude = latitude;
+    dtedCellPathEntry.longitude = longitude;
+
+    {
+        boost::mutex::scoped_lock lock(loadMutex);
+
+        // No coverage, nothing to pin.
+        if (!Directory(level)->Retrieve_Dted_Entry(dtedCellPathEntry))
+            return true;
+    }
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    Dted_Cell* prevCellPtr = cellGrid->Get(latitude, longitude);
+
+    if ((prevCellPtr != NULL) && prevCellPtr->hasDirectPosts())
+        return prevCellPtr->pinPosts(lockMemory);
+
+    Dted_Cell* dtedCellPtr = Create_Cell(dtedCellPathEntry, true, false);
+
+    if (!dtedCellPtr->pinPosts(lockMemory)) {
+        delete dtedCellPtr;
+        return false;
+    }
+
+    if (prevCellPtr != NULL)
+        dtedCellPtr->setAccessCount(prevCellPtr->getAccessCount());
+
+    bool published =
+            (prevCellPtr == NULL) ?
+                    cellGrid->Publish(latitude, longitude, dtedCellPtr) :
+                    cellGrid->Replace(latitude, longitude, prevCellPtr,
+                            dtedCellPtr);
+
+    if (!published) {
+        // Another thread changed the cell meanwhile; pin its copy.
+        delete dtedCellPtr;
+        return Pin_Cell(level, latitude, longitude, lockMemory);
     }
 
-    return elevHeight;
+    if (prevCellPtr != NULL)
+        cellEpoch.Retire(prevCellPtr, Dted_Epoch::Delete_Object<Dted_Cell>);
+
+    return true;
 }
 
-void Dted_Database::Set_Dted_Level(Dted_Level newDtedLevel) {
-    dtedLevel = newDtedLevel;
+void Dted_Database::Set_Real_Time_Active(bool newState) {
+    realTimeActive = newState;
 }
 
-Dted_Level Dted_Database::Get_Dted_Level() {
-    return dtedLevel;
+bool Dted_Database::Register_Real_Time_Thread() {
+    return cellEpoch.Register_Thread();
 }
 
-bool Dted_Database::Populate_Dted1_Directory(const string& path, bool preLoad) {
-    Dted_Cell_Path_Entry dtedCellPathEntry;
+namespace {
+
+//! Runs one location of a Get_Geo_Elevs() call.
+struct Bulk_Query {
+    Dted_Database* database;
+    const vector<Geo_Location>* locations;
+    const Query_Options* options;
+    vector<double>* elevations;
+
+    void operator()(size_t item) {
+        database->Get_Geo_Elev((*locations)[item], *options,
+                (*elevations)[item]);
+    }
+};
 
-    dted1_dir.Populate_Directory(path);
+}
+
+void Dted_Database::Get_Geo_Elevs(const vector<Geo_Location>& locations,
+        vector<double>& elevations) {
+    Get_Geo_Elevs(locations, Get_Query_Options(), elevations);
+}
+
+void Dted_Database::Get_Geo_Elevs(const vector<Geo_Location>& locations,
+        const Query_Options& options, vector<double>& elevations) {
+    elevations.resize(locations.size());
+
+    if (numaPlacement == NUMA_NONE) {
+        for (size_t i = 0; i < locations.size(); i++)
+            Get_Geo_Elev(locations[i], options, elevations[i]);
+
+        return;
+    }
+
+    vector<vector<size_t> > nodeItems(nodeArenas.size());
 
-    if (preLoad) {
-        dted1_dir.QueryReset();
+    for (size_t i = 0; i < locations.size(); i++) {
+        short latitude;
+        short longitude;
 
-        while (dted1_dir.Query(dtedCellPathEntry)) {
-            Dted_Cell* dtedCellPtr = new Dted_Cell(dtedCellPathEntry.cellPath);
+        Dted_Cell_Grid::Cell_Corner(locations[i], latitude, longitude);
 
-            dtedCellPtr->loadCellFromDisk();
-            dted1CellSet.insert(dtedCellPtr);
+        if (!Dted_Cell_Grid::Is_Valid(latitude, longitude)) {
+            Get_Geo_Elev(locations[i], options, elevations[i]);
+            continue;
         }
+
+        nodeItems[Cell_Node(latitude, longitude)].push_back(i);
     }
 
-    if (debug) {
-        cout << "\nDL1 Minimum meridian is : " << dted1_dir.getMinMeridian()
-                << endl << "DL1 Maximum meridian is   : "
-                << dted1_dir.getMaxMeridian() << endl
-                << "DL1 Minimum parallel is   : " << dted1_dir.getMinParallel()
-                << endl << "DL1 Maximum parallel is   : "
-                << dted1_dir.getMaxParallel() << endl;
+    Bulk_Query bulkQuery;
+    bulkQuery.database = this;
+    bulkQuery.locations = &locations;
+    bulkQuery.options = &options;
+    bulkQuery.elevations = &elevations;
+
+    queryRouter.Run(nodeItems, bulkQuery);
+}
+
+Dted_Level_Store* Dted_Database::Store(Dted_Level level) {
+    if ((level < LEVEL_0) || ((int) level >= NUM_LEVELS))
+        return NULL;
+
+    return levelStores[level];
+}
+
+const Dted_Level_Store* Dted_Database::Store(Dted_Level level) const {
+    if ((level < LEVEL_0) || ((int) level >= NUM_LEVELS))
+        return NULL;
+
+    return levelStores[level];
+}
+
+Dted_Cell_Grid* Dted_Database::Cell_Grid(Dted_Level level) {
+    Dted_Level_Store* store = Store(level);
+
+    return (store == NULL) ? NULL : &store->Cell_Grid();
+}
+
+const Dted_Cell_Grid* Dted_Database::Cell_Grid(Dted_Level level) const {
+    const Dted_Level_Store* store = Store(level);
+
+    return (store == NULL) ? NULL : &store->Cell_Grid();
+}
+
+Dted_Coverage* Dted_Database::Coverage(Dted_Level level) {
+    Dted_Level_Store* store = Store(level);
+
+    return (store == NULL) ? NULL : &store->Coverage();
+}
+
+const Dted_Coverage* Dted_Database::Coverage(Dted_Level level) const {
+    const Dted_Level_Store* store = Store(level);
+
+    return (store == NULL) ? NULL : &store->Coverage();
+}
+
+void Dted_Database::Update_Coverage(Dted_Level level) {
+    boost::mutex::scoped_lock lock(loadMutex);
+
+    Coverage(level)->Build(*Directory(level));
+}
+
+Dted_Directory* Dted_Database::Directory(Dted_Level level) {
+    Dted_Level_Store* store = Store(level);
+
+    return (store == NULL) ? NULL : &store->Directory();
+}
+
+Dted_Cell* Dted_Database::Create_Cell(
+        const Dted_Cell_Path_Entry& dtedCellPathEntry, bool loadPosts,
+        bool allowCompression) {
+    Dted_Cell* dtedCellPtr;
+
+    if (loadPosts) {
+        dtedCellPtr = sharedCache.Create_Cell(dtedCellPathEntry);
+
+        if (dtedCellPtr != NULL)
+            return dtedCellPtr;
     }
 
-    return true;
+    if (dtedCellPathEntry.archive)
+        dtedCellPtr = new Dted_Cell(dtedCellPathEntry.archive,
+                dtedCellPathEntry.latitude, dtedCellPathEntry.longitude);
+    else
+        dtedCellPtr = new Dted_Cell(dtedCellPathEntry.cellPath);
+
+    // Also serves batch loads, which load the posts later.
+    if (numaPlacement != NUMA_NONE)
+        dtedCellPtr->setTileArena(
+                nodeArenas[Cell_Node(dtedCellPathEntry.latitude,
+                        dtedCellPathEntry.longitude)].get());
+    else if (tileArenaActive)
+        dtedCellPtr->setTileArena(&tileArena);
+
+    if (loadPosts) {
+        dtedCellPtr->loadCellFromDisk();
+
+        if (allowCompression && (accessMethod == COMPRESSED_ACCESS))
+            dtedCellPtr->compressPosts();
+    } else if (accessMethod == PAGED_ACCESS) {
+        dtedCellPtr->setPageCache(&pageCache);
+    }
 
+    return dtedCellPtr;
 }
 
-bool Dted_Database::Populate_Dted2_Directory(const string& path, bool preLoad) {
-    Dted_Cell_Path_Entry dtedCellPathEntry;
+Dted_Cell* Dted_Database::Load_Cell(Dted_Level level,
+        const Geo_Location& geoLoc) {
+    Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+    Dted_Directory* directory = Directory(level);
+
+    if ((cellGrid == NULL) || (directory == NULL))
+        return NULL;
 
-    dted2_dir.Populate_Directory(path);
+    // Uncovered cells miss without taking the lock.
+    if (!Coverage(level)->Covers(geoLoc))
+        return NULL;
 
-    if (preLoad) {
-        dted2_dir.QueryReset();
+    Dted_Cell_Loader::Load_Request request;
+    request.level = level;
+    request.loadPosts = Load_Posts();
 
-        while (dted2_dir.Query(dtedCellPathEntry)) {
-            Dted_Cell* dtedCellPtr = new Dted_Cell(dtedCellPathEntry.cellPath);
+    Dted_Cell_Grid::Cell_Corner(geoLoc, request.entry.latitude,
+            request.entry.longitude);
 
-            dtedCellPtr->loadCellFromDisk();
-            dted2CellSet.insert(dtedCellPtr);
+    {
+        boost::mutex::scoped_lock lock(loadMutex);
+
+        if (request.entry == prevFailedCellPathEntry)
+            return NULL;
+
+        if (!directory->Retrieve_Dted_Entry(request.entry)) {
+            prevFailedCellPathEntry = request.entry;
+            return NULL;
         }
     }
 
-    if (debug) {
-        cout << "\nDL2 Minimum meridian is : " << dted2_dir.getMinMeridian()
-                << endl << "DL2 Maximum meridian is   : "
-                << dted2_dir.getMaxMeridian() << endl
-                << "DL2 Minimum parallel is   : " << dted2_dir.getMinParallel()
-                << endl << "DL2 Maximum parallel is   : "
-                << dted2_dir.getMaxParallel() << endl;
+    // Runs on this thread ahead of any queued prefetch or preload.
+    cellLoader.Load_Now(request);
+
+    Dted_Cell* dtedCellPtr = cellGrid->Find(geoLoc);
+
+    if (dtedCellPtr == NULL) {
+        // Unloaded again before we got to it; use a private copy which
+        // stays valid until our epoch guard is released.
+        dtedCellPtr = Create_Cell(request.entry, request.loadPosts);
+
+        if (!cellGrid->Publish(request.entry.latitude,
+                request.entry.longitude, dtedCellPtr))
+            cellEpoch.Retire(dtedCellPtr,
+                    Dted_Epoch::Delete_Object<Dted_Cell>);
     }
 
-    return true;
+    return dtedCellPtr;
 }
 
-void Dted_Database::Gather_Stats_Dted1() {
-    float minHeightAboveMSL = 65536;
-    float maxHeightAboveMSL = 0;
+bool Dted_Database::Unload_Cell(Dted_Level level, short latitude,
+        short longitude) {
+    Dted_Cell_Grid* cellGrid = Cell_Grid(level);
 
-    Dted_Cell_Set::const_iterator it = dted1CellSet.begin();
+    if (cellGrid == NULL)
+        return false;
 
-    while (it != dted1CellSet.end()) {
-        Dted_Cell* dtedCellPtr = (Dted_Cell*) *it;
+    Dted_Cell* dtedCellPtr;
+    {
+        boost::mutex::scoped_lock lock(loadMutex);
+        dtedCellPtr = cellGrid->Exchange(latitude, longitude, NULL);
+    }
 
-        dtedCellPtr->gatherStatistics();
+    if (dtedCellPtr == NULL)
+        return false;
 
-        if (dtedCellPtr->minHeightAboveMSL() < minHeightAboveMSL)
-            minHeightAboveMSL = dtedCellPtr->minHeightAboveMSL();
+    cellEpoch.Retire(dtedCellPtr, Dted_Epoch::Delete_Object<Dted_Cell>);
 
-        if (dtedCellPtr->maxHeightAboveMSL() > maxHeightAboveMSL)
-            maxHeightAboveMSL = dtedCellPtr->maxHeightAboveMSL();
+    return true;
+}
 
-        it++;
+bool Dted_Database::Reload_Cell(Dted_Level level, short latitude,
+        short longitude) {
+    Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+    Dted_Directory* directory = Directory(level);
+
+    if ((cellGrid == NULL) || (directory == NULL))
+        return false;
+
+    Dted_Cell_Path_Entry dtedCellPathEntry;
+    dtedCellPathEntry.latitude = latitude;
+    dtedCellPathEntry.longitude = longitude;
+
+    {
+        boost::mutex::scoped_lock lock(loadMutex);
+
+        if (!directory->Retrieve_Dted_Entry(dtedCellPathEntry))
+            return false;
     }
 
-    cout << "Stats Report" << endl << "min DTED1 = " << minHeightAboveMSL
-            << endl << "max DTED1 = " << maxHeightAboveMSL << endl;
+    // Read the replacement outside of loadMutex, and before publishing,
+    // so that neither queries nor other loads stall.
+    Dted_Cell* dtedCellPtr = Create_Cell(dtedCellPathEntry, Load_Posts());
+
+    Dted_Cell* prevCellPtr = cellGrid->Exchange(latitude, longitude,
+            dtedCellPtr);
 
+    if (prevCellPtr != NULL)
+        cellEpoch.Retire(prevCellPtr, Dted_Epoch::Delete_Object<Dted_Cell>);
+
+    return true;
 }
 
-void Dted_Database::Gather_Stats_Dted2() {
-    float minHeightAboveMSL = 65536;
-    float maxHeightAboveMSL = 0;
+bool Dted_Database::Load_Requested_Cell(
+        const Dted_Cell_Loader::Load_Request& request) {
+    Dted_Cell_Grid* cellGrid = Cell_Grid(request.level);
 
-    Dted_Cell_Set::const_iterator it = dted2CellSet.begin();
+    if (cellGrid == NULL)
+        return false;
 
-    while (it != dted2CellSet.end()) {
-        Dted_Cell* dtedCellPtr = (Dted_Cell*) *it;
+    Dted_Epoch::Guard guard(cellEpoch);
 
-        dtedCellPtr->gatherStatistics();
+    Dted_Cell* prevCellPtr = cellGrid->Get(request.entry.latitude,
+            request.entry.longitude);
 
-        if (dtedCellPtr->minHeightAboveMSL() < minHeightAboveMSL)
-            minHeightAboveMSL = dtedCellPtr->minHeightAboveMSL();
+    // A loaded cell only has its posts loaded by a HYBRID_ACCESS
+    // promotion.
+    if ((prevCellPtr != NULL)
+            && (!request.loadPosts || (accessMethod != HYBRID_ACCESS)
+                    || prevCellPtr->isResident()))
+        return true;
 
-        if (dtedCellPtr->maxHeightAboveMSL() > maxHeightAboveMSL)
-            maxHeightAboveMSL = dtedCellPtr->maxHeightAboveMSL();
+    // Loads run in parallel; only publishing is atomic.
+    Dted_Cell* dtedCellPtr = Create_Cell(request.entry, request.loadPosts);
 
-        it++;
+    if (prevCellPtr == NULL) {
+        if (cellGrid->Publish(request.entry.latitude,
+                request.entry.longitude, dtedCellPtr))
+            residentEstimate += dtedCellPtr->getResidentSize();
+        else
+            delete dtedCellPtr;
+
+        return true;
     }
 
-    cout << "Stats Report" << endl << "min DTED2 = " << minHeightAboveMSL
-            << endl << "max DTED2 = " << maxHeightAboveMSL << endl;
+    // Promotion: queries keep reading the disk copy until the resident
+    // copy replaces it.
+    if (!dtedCellPtr->isResident()) {
+        delete dtedCellPtr;
+        return false;
+    }
 
-}
+    dtedCellPtr->setAccessCount(prevCellPtr->getAccessCount());
 
-void Dted_Database::Set_Access_Method(Access_Method newMethod) {
-    accessMethod = newMethod;
+    if (cellGrid->Replace(request.entry.latitude, request.entry.longitude,
+            prevCellPtr, dtedCellPtr)) {
+        residentEstimate += dtedCellPtr->getResidentSize();
+        cellEpoch.Retire(prevCellPtr, Dted_Epoch::Delete_Object<Dted_Cell>);
+    } else {
+        delete dtedCellPtr;
+    }
+
+    Enforce_Memory_Budget();
+
+    return true;
 }
 
-Access_Method Dted_Database::Get_Access_Method() const {
-    return accessMethod;
+namespace {
+
+//! Publishes the cells of a batch as their posts arrive.
+struct Batch_Publisher {
+    vector<Dted_Cell_Grid*>* cellGrids;
+    const vector<Dted_Cell_Loader::Load_Request>* requests;
+    vector<Dted_Cell*>* cells;
+    vector<bool>* loaded;
+    boost::mutex* mutex;
+    bool compress;
+    boost::atomic<size_t>* residentEstimate;
+
+    void operator()(const Dted_Async_Reader::Read_Request& read, bool ok) {
+        Dted_Cell* dtedCellPtr = (*cells)[read.index];
+        const Dted_Cell_Path_Entry& entry = (*requests)[read.index].entry;
+
+        if (ok) {
+            // Decode while the other reads are still in flight.
+            dtedCellPtr->adoptDataRegion(read.buffer);
+
+            if (compress)
+                dtedCellPtr->compressPosts();
+
+            if ((*cellGrids)[read.index]->Publish(entry.latitude,
+                    entry.longitude, dtedCellPtr))
+                *residentEstimate += dtedCellPtr->getResidentSize();
+            else
+                delete dtedCellPtr;
+        } else {
+            free(read.buffer);
+            delete dtedCellPtr;
+        }
+
+        boost::mutex::scoped_lock lock(*mutex);
+        (*loaded)[read.index] = ok;
+    }
+};
+
+}
+
+void Dted_Database::Load_Requested_Cells(
+        const vector<Dted_Cell_Loader::Load_Request>& requests,
+        vector<bool>& loaded) {
+    vector<Dted_Cell*> cells(requests.size(), (Dted_Cell*) NULL);
+    vector<Dted_Cell_Grid*> cellGrids(requests.size(),
+            (Dted_Cell_Grid*) NULL);
+    vector<Dted_Async_Reader::Read_Request> reads;
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        const Dted_Cell_Loader::Load_Request& request = requests[i];
+        Dted_Cell_Grid* cellGrid = Cell_Grid(request.level);
+
+        if (cellGrid == NULL) {
+            loaded[i] = false;
+            continue;
+        }
+
+        if (cellGrid->Get(request.entry.latitude, request.entry.longitude)
+                != NULL) {
+            // Promotions replace the loaded cell one at a time.
+            loaded[i] = Load_Requested_Cell(request);
+            continue;
+        }
+
+        // Cells of the shared cache are mapped rather than read.
+        Dted_Cell* dtedCellPtr = Create_Cell(request.entry,
+                request.loadPosts && sharedCache.Is_Open());
+
+        // Packed and archived cells are mapped as they are opened.
+        if (!request.loadPosts || dtedCellPtr->isResident()) {
+            if (!cellGrid->Publish(request.entry.latitude,
+                    request.entry.longitude, dtedCellPtr))
+                delete dtedCellPtr;
+
+            loaded[i] = true;
+            continue;
+        }
+
+        Dted_Async_Reader::Read_Request read;
+        read.fd = open(request.entry.cellPath.c_str(), O_RDONLY);
+        read.offset = dtedCellPtr->getDataRegionOffset();
+        read.length = dtedCellPtr->getDataRegionSize();
+        read.buffer = NULL;
+        read.index = i;
+
+        if ((read.fd < 0) || (read.length == 0)) {
+            if (read.fd >= 0)
+                close(read.fd);
+
+            delete dtedCellPtr;
+            loaded[i] = false;
+            continue;
+        }
+
+        read.buffer = (unsigned char*) malloc(read.length);
+
+        if (read.buffer == NULL) {
+            close(read.fd);
+            delete dtedCellPtr;
+            loaded[i] = false;
+            continue;
+        }
+
+        cells[i] = dtedCellPtr;
+        cellGrids[i] = cellGrid;
+        reads.push_back(read);
+    }
+
+    if (reads.empty())
+        return;
+
+    boost::mutex loadedMutex;
+
+    Batch_Publisher publisher;
+    publisher.cellGrids = &cellGrids;
+    publisher.requests = &requests;
+    publisher.cells = &cells;
+    publisher.loaded = &loaded;
+    publisher.mutex = &loadedMutex;
+    publisher.compress = (accessMethod == COMPRESSED_ACCESS);
+    publisher.residentEstimate = &residentEstimate;
+
+    if (batchReader.get() == NULL)
+        batchReader.reset(
+                new Dted_Async_Reader(Dted_Cell_Loader::MAX_BATCH_SIZE));
+
+    batchReader->Read_All(reads, publisher);
+
+    for (size_t i = 0; i < reads.size(); i++)
+        close(reads[i].fd);
+
+    Enforce_Memory_Budget();
+}
+
+void Dted_Database::Submit_Prefetch(Dted_Load_Handle& handle,
+        Dted_Level level, short latitude, short longitude,
+        Load_Priority priority) {
+    Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+    Dted_Directory* directory = Directory(level);
+
+    if ((cellGrid == NULL) || (directory == NULL))
+        return;
+
+    if (cellGrid->Get(latitude, longitude) != NULL)
+        return;
+
+    Dted_Cell_Loader::Load_Request request;
+    request.level = level;
+    request.entry.latitude = latitude;
+    request.entry.longitude = longitude;
+    request.loadPosts = Load_Posts();
+
+    if (directory->Retrieve_Dted_Entry(request.entry))
+        cellLoader.Submit(handle, request, priority);
+}
+
+Dted_Load_Handle Dted_Database::Prefetch_Region(const Geo_Box& box,
+        Dted_Level level) {
+    Dted_Load_Handle handle = cellLoader.Begin_Batch();
+
+    short minLatitude = (short) floor(box.southWest.lat);
+    short minLongitude = (short) floor(box.southWest.lon);
+    short maxLatitude = (short) floor(box.northEast.lat);
+    short maxLongitude = (short) floor(box.northEast.lon);
+
+    for (short lat = minLatitude; lat <= maxLatitude; lat++) {
+        for (short lon = minLongitude; lon <= maxLongitude; lon++)
+            Submit_Prefetch(handle, level, lat, lon, LOAD_PREFETCH);
+    }
+
+    cellLoader.Commit(handle);
+
+    return handle;
+}
+
+Dted_Load_Handle Dted_Database::Prefetch_Cells(
+        const vector<Geo_Location>& locations, Dted_Level level,
+        Load_Priority priority) {
+    Dted_Load_Handle handle = cellLoader.Begin_Batch();
+
+    for (size_t i = 0; i < locations.size(); i++) {
+        short latitude;
+        short longitude;
+
+        Dted_Cell_Grid::Cell_Corner(locations[i], latitude, longitude);
+
+        // The loader skips duplicates once the first copy is published.
+        Submit_Prefetch(handle, level, latitude, longitude, priority);
+    }
+
+    cellLoader.Commit(handle);
+
+    return handle;
+}
+
+void Dted_Database::Set_Loader_Threads(int threadCount) {
+    cellLoader.Set_Thread_Count(threadCount);
+}
+
+void Dted_Database::Set_Device_Concurrency(int deviceConcurrency) {
+    cellLoader.Set_Device_Concurrency(deviceConcurrency);
+}
+
+void Dted_Database::Preload_Directory(Dted_Level level) {
+    Dted_Directory* directory = Directory(level);
+    Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+    Dted_Load_Handle handle = cellLoader.Begin_Batch();
+
+    Dted_Cell_Loader::Load_Request request;
+    request.level = level;
+    request.loadPosts = true;
+
+    directory->QueryReset();
+
+    while (directory->Query(request.entry)) {
+        if (cellGrid->Get(request.entry.latitude, request.entry.longitude)
+                == NULL)
+            cellLoader.Submit(handle, request, LOAD_SPECULATIVE);
+    }
+
+    cellLoader.Commit(handle);
+
+    // Foreground misses from other threads run ahead of the preload.
+    handle.Wait();
+}
+
+void Dted_Database::Reclaim_Cells() {
+    cellEpoch.Collect();
+}
+
+void Dted_Database::Set_Working_Set_Recording(bool newState) {
+    if (newState && !recordingActive)
+        workingSet.Reset();
+
+    recordingActive = newState;
+}
+
+bool Dted_Database::Save_Working_Set(const string& path) {
+    return workingSet.Save(path);
+}
+
+bool Dted_Database::Preload_Working_Set(const string& path) {
+    vector<Dted_Working_Set::Entry> entries;
+
+    if (!Dted_Working_Set::Load(path, entries))
+        return false;
+
+    Dted_Load_Handle handle = cellLoader.Begin_Batch();
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        // Batches of consecutive cells load in parallel, in list order.
+        Submit_Prefetch(handle, entries[i].level, entries[i].latitude,
+                entries[i].longitude, LOAD_PREFETCH);
+    }
+
+    cellLoader.Commit(handle);
+    handle.Wait();
+
+    return true;
+}
+
+bool Dted_Database::Save_Snapshot(const string& path) {
+    // Write aside and rename so a crash never leaves a partial snapshot.
+    string tempPath = path + ".tmp";
+    fstream snapshotStr(tempPath.c_str(),
+            ios::in | ios::out | ios::binary | ios::trunc);
+
+    if (!snapshotStr.is_open())
+        return false;
+
+    char page[Dted_Packed_Header::PAGE_SIZE];
+    memset(page, 0, sizeof(page));
+
+    // Header placeholder, rewritten once the sections are known.
+    snapshotStr.write(page, sizeof(page));
+
+    Dted_Snapshot_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "DTEDSNAP", sizeof(header.magic));
+    header.version = Dted_Snapshot_Header::VERSION;
+    header.byteOrder = Dted_Packed_Header::BYTE_ORDER_MARK;
+
+    bool written = true;
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    for (int l = 0; l < NUM_LEVELS; l++) {
+        Dted_Snapshot_Header::Level_Section& section =
+                header.levels[header.levelCount++];
+        Dted_Directory* directory = &levelStores[l]->Directory();
+
+        section.level = levelStores[l]->Get_Level();
+        section.directoryOffset = snapshotStr.tellp();
+
+        vector<Dted_Cell*> cells;
+        levelStores[l]->Cell_Grid().Snapshot(cells);
+
+        vector<pair<Dted_Cell_Path_Entry, Dted_Cell*> > loadedCells;
+        {
+            boost::mutex::scoped_lock lock(loadMutex);
+
+            written = directory->Save_Directory(snapshotStr) && written;
+
+            for (size_t i = 0; i < cells.size(); i++) {
+                Geo_Location cellCenter = cells[i]->getSwCornerPost();
+                cellCenter.lat += 0.5;
+                cellCenter.lon += 0.5;
+
+                pair<Dted_Cell_Path_Entry, Dted_Cell*> loadedCell;
+                Dted_Cell_Grid::Cell_Corner(cellCenter,
+                        loadedCell.first.latitude, loadedCell.first.longitude);
+
+                // Cells without their posts are read afresh for the
+                // snapshot rather than loaded under running queries.
+                loadedCell.second =
+                        cells[i]->isResident() ? cells[i] : (Dted_Cell*) NULL;
+
+                if (directory->Retrieve_Dted_Entry(loadedCell.first))
+                    loadedCells.push_back(loadedCell);
+            }
+        }
+
+        section.directorySize = (unsigned long long) snapshotStr.tellp()
+                - section.directoryOffset;
+
+        size_t padding = (Dted_Packed_Header::PAGE_SIZE
+                - section.directorySize % Dted_Packed_Header::PAGE_SIZE)
+                % Dted_Packed_Header::PAGE_SIZE;
+        snapshotStr.write(page, padding);
+
+        sort(loadedCells.begin(), loadedCells.end());
+
+        vector<Dted_Cell_Path_Entry> cellEntries;
+        vector<Dted_Cell*> cellPtrs;
+
+        for (size_t i = 0; i < loadedCells.size(); i++) {
+            cellEntries.push_back(loadedCells[i].first);
+            cellPtrs.push_back(loadedCells[i].second);
+        }
+
+        section.archiveOffset = snapshotStr.tellp();
+
+        written = (Dted_Archive::Write(cellEntries, cellPtrs, snapshotStr)
+                >= 0) && written;
+    }
+
+    snapshotStr.seekp(0, ios::beg);
+    snapshotStr.write((const char*) &header, sizeof(header));
+    snapshotStr.close();
+
+    if (!written || snapshotStr.fail()
+            || (rename(tempPath.c_str(), path.c_str()) != 0)) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool Dted_Database::Load_Snapshot(const string& path) {
+    ifstream snapshotStr(path.c_str(), ios::in | ios::binary);
+
+    if (!snapshotStr.is_open())
+        return false;
+
+    Dted_Snapshot_Header header;
+    snapshotStr.read((char*) &header, sizeof(header));
+
+    if ((snapshotStr.gcount() != (streamsize) sizeof(header))
+            || !Dted_Snapshot_Header::Has_Magic(header.magic)
+            || (header.version != Dted_Snapshot_Header::VERSION)
+            || (header.byteOrder != Dted_Packed_Header::BYTE_ORDER_MARK)
+            || (header.levelCount > Dted_Snapshot_Header::MAX_LEVELS)) {
+        cerr << "ERROR: Invalid snapshot: '" << path << "'" << endl;
+        return false;
+    }
+
+    Clear_Database();
+
+    for (unsigned int l = 0; l < header.levelCount; l++) {
+        const Dted_Snapshot_Header::Level_Section& section = header.levels[l];
+        Dted_Level level = (Dted_Level) section.level;
+        Dted_Directory* directory = Directory(level);
+        Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+
+        if ((directory == NULL) || (cellGrid == NULL))
+            continue;
+
+        vector<char> directoryData(section.directorySize);
+
+        snapshotStr.seekg(section.directoryOffset, ios::beg);
+
+        if (!directoryData.empty())
+            snapshotStr.read(&directoryData[0], directoryData.size());
+
+        boost::shared_ptr<Dted_Archive> archive(new Dted_Archive());
+        bool restored;
+        {
+            boost::mutex::scoped_lock lock(loadMutex);
+
+            restored = !snapshotStr.fail()
+                    && directory->Restore_Directory(
+                            directoryData.empty() ? NULL : &directoryData[0],
+                            directoryData.size());
+
+            if (restored)
+                Coverage(level)->Build(*directory);
+        }
+
+        if (!restored || !archive->Open(path, section.archiveOffset)) {
+            cerr << "ERROR: Invalid snapshot: '" << path << "'" << endl;
+            Clear_Database();
+            return false;
+        }
+
+        for (int i = 0; i < archive->Get_Cell_Count(); i++) {
+            const Dted_Archive::Index_Entry& entry = archive->Get_Entry(i);
+            Dted_Cell* dtedCellPtr = new Dted_Cell(archive, entry.latitude,
+                    entry.longitude);
+
+            if (!cellGrid->Publish(entry.latitude, entry.longitude,
+                    dtedCellPtr))
+                delete dtedCellPtr;
+        }
+    }
+
+    return true;
+}
+
+int Dted_Database::Get_Loaded_Cell_Count(Dted_Level level) const {
+    const Dted_Cell_Grid* cellGrid = Cell_Grid(level);
+
+    return (cellGrid == NULL) ? 0 : cellGrid->Size();
+}
+
+Query_Status Dted_Database::Get_Level_Geo_Elev(Dted_Level_Store& store,
+        Geo_Location geoLoc, Interpolation_Mode interpolation,
+        double& elevation) {
+    Dted_Level level = store.Get_Level();
+    double elevHeight = 0.0;
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    Dted_Cell* dtedCellPtr = store.Cell_Grid().Find(geoLoc);
+
+    // Load cell from file.
+    if (dtedCellPtr == NULL)
+        dtedCellPtr = Load_Cell(level, geoLoc);
+
+    if (dtedCellPtr == NULL)
+        return QUERY_NO_COVERAGE;
+
+    if (recordingActive)
+        workingSet.Record(level, geoLoc);
+
+    if (Read_Resident(level, geoLoc, dtedCellPtr))
+        elevHeight = dtedCellPtr->getHeightAboveMSL(geoLoc, interpolation);
+    else
+        // Using disk access
+        elevHeight = dtedCellPtr->getHeightAboveMSLFromDisk(geoLoc,
+                interpolation);
+
+    if (elevHeight == NULL_POST)
+        return QUERY_VOID_POST;
+
+    elevation = elevHeight;
+
+    return QUERY_OK;
+}
+
+Query_Status Dted_Database::Get_Level_Post_Elev(Dted_Level_Store& store,
+        Geo_Location geoLoc, Voxel pointLoc, double& elevation) {
+    Dted_Level level = store.Get_Level();
+    double elevHeight = 0.0;
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    Dted_Cell* dtedCellPtr = store.Cell_Grid().Find(geoLoc);
+
+    // Load cell from file.
+    if (dtedCellPtr == NULL)
+        dtedCellPtr = Load_Cell(level, geoLoc);
+
+    if (dtedCellPtr == NULL)
+        return QUERY_NO_COVERAGE;
+
+    if (recordingActive)
+        workingSet.Record(level, geoLoc);
+
+    if (!dtedCellPtr->containsPost(pointLoc))
+        return QUERY_OUT_OF_RANGE;
+
+    if (Read_Resident(level, geoLoc, dtedCellPtr))
+        elevHeight = dtedCellPtr->getPostValue(pointLoc);
+    else
+        // Using disk access
+        elevHeight = dtedCellPtr->getPostValueFromDisk(pointLoc);
+
+    if (elevHeight == NULL_POST)
+        return QUERY_VOID_POST;
+
+    elevation = elevHeight;
+
+    return QUERY_OK;
+}
+
+void Dted_Database::Set_Dted_Level(Dted_Level newDtedLevel) {
+    dtedLevel = newDtedLevel;
+}
+
+Dted_Level Dted_Database::Get_Dted_Level() {
+    return dtedLevel;
+}
+
+bool Dted_Database::Populate_Directory(Dted_Level level,
+        const string& path, bool preLoad) {
+    Dted_Level_Store* store = Store(level);
+
+    if (store == NULL)
+        return false;
+
+    Dted_Directory& directory = store->Directory();
+
+    directory.Populate_Directory(path);
+    Update_Coverage(level);
+
+    if (preLoad)
+        Preload_Directory(level);
+
+    if (debug) {
+        cout << "\n" << store->Get_Name() << " Minimum meridian is : "
+                << directory.getMinMeridian() << endl << store->Get_Name()
+                << " Maximum meridian is   : " << directory.getMaxMeridian()
+                << endl << store->Get_Name() << " Minimum parallel is   : "
+                << directory.getMinParallel() << endl << store->Get_Name()
+                << " Maximum parallel is   : " << directory.getMaxParallel()
+                << endl;
+    }
+
+    return true;
+}
+
+bool Dted_Database::Populate_Dted0_Directory(const string& path, bool preLoad) {
+    return Populate_Directory(LEVEL_0, path, preLoad);
+}
+
+bool Dted_Database::Populate_Dted1_Directory(const string& path, bool preLoad) {
+    return Populate_Directory(LEVEL_1, path, preLoad);
+}
+
+bool Dted_Database::Populate_Dted2_Directory(const string& path, bool preLoad) {
+    return Populate_Directory(LEVEL_2, path, preLoad);
+}
+
+void Dted_Database::Gather_Stats(Dted_Level level) {
+    Dted_Level_Store* store = Store(level);
+    float minHeightAboveMSL = 65536;
+    float maxHeightAboveMSL = 0;
+
+    if (store == NULL)
+        return;
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    vector<Dted_Cell*> cells;
+    store->Cell_Grid().Snapshot(cells);
+
+    vector<Dted_Cell*>::const_iterator it = cells.begin();
+
+    while (it != cells.end()) {
+        Dted_Cell* dtedCellPtr = *it;
+
+        dtedCellPtr->gatherStatistics();
+
+        if (dtedCellPtr->minHeightAboveMSL() < minHeightAboveMSL)
+            minHeightAboveMSL = dtedCellPtr->minHeightAboveMSL();
+
+        if (dtedCellPtr->maxHeightAboveMSL() > maxHeightAboveMSL)
+            maxHeightAboveMSL = dtedCellPtr->maxHeightAboveMSL();
+
+        it++;
+    }
+
+    cout << "Stats Report" << endl << "min " << store->Get_Name() << " = "
+            << minHeightAboveMSL << endl << "max " << store->Get_Name()
+            << " = " << maxHeightAboveMSL << endl;
+
+}
+
+void Dted_Database::Gather_Stats_Dted0() {
+    Gather_Stats(LEVEL_0);
+}
+
+void Dted_Database::Gather_Stats_Dted1() {
+    Gather_Stats(LEVEL_1);
+}
+
+void Dted_Database::Gather_Stats_Dted2() {
+    Gather_Stats(LEVEL_2);
+}
+
+void Dted_Database::Set_Access_Method(Access_Method newMethod) {
+    accessMethod = newMethod;
+}
+
+Access_Method Dted_Database::Get_Access_Method() const {
+    return accessMethod;
+}
+
+bool Dted_Database::Set_Shared_Cache(const string& directory) {
+    if (directory.empty()) {
+        sharedCache.Close();
+        return true;
+    }
+
+    return sharedCache.Open(directory);
+}
+
+void Dted_Database::Set_Tile_Arena_Active(bool newState, bool hugeTlb) {
+    tileArena.Set_Huge_Tlb(hugeTlb);
+    tileArenaActive = newState;
+    tileArenaHugeTlb = hugeTlb;
+
+    for (size_t node = 0; node < nodeArenas.size(); node++)
+        nodeArenas[node]->Set_Huge_Tlb(hugeTlb);
+}
+
+void Dted_Database::Set_Numa_Placement(Numa_Placement placement) {
+    // Arenas are never released while cells may use them.
+    if ((placement != NUMA_NONE) && nodeArenas.empty()) {
+        for (int node = 0; node < Dted_Numa::Get_Node_Count(); node++) {
+            boost::shared_ptr<Dted_Tile_Arena> nodeArena(
+                    new Dted_Tile_Arena());
+            nodeArena->Set_Node(node);
+            nodeArena->Set_Huge_Tlb(tileArenaHugeTlb);
+            nodeArenas.push_back(nodeArena);
+        }
+    }
+
+    numaPlacement = placement;
+}
+
+void Dted_Database::Set_Query_Threads_Per_Node(int threadsPerNode) {
+    queryRouter.Set_Threads_Per_Node(threadsPerNode);
+}
+
+int Dted_Database::Cell_Node(short latitude, short longitude) const {
+    int nodeCount = nodeArenas.size();
+
+    if (numaPlacement == NUMA_INTERLEAVE)
+        return ((latitude + Dted_Cell_Grid::NUM_PARALLELS / 2)
+                + (longitude + Dted_Cell_Grid::NUM_MERIDIANS / 2)) % nodeCount;
+
+    if (numaPlacement == NUMA_SPATIAL)
+        return (longitude + Dted_Cell_Grid::NUM_MERIDIANS / 2) * nodeCount
+                / Dted_Cell_Grid::NUM_MERIDIANS;
+
+    return 0;
+}
+
+void Dted_Database::Set_Page_Cache_Size(size_t bytes) {
+    pageCache.Set_Capacity(bytes);
+}
+
+void Dted_Database::Set_Memory_Budget(size_t bytes) {
+    memoryBudget = bytes;
+    Enforce_Memory_Budget(true);
+}
+
+void Dted_Database::Set_Promote_Threshold(unsigned int accesses) {
+    promoteThreshold = accesses;
+}
+
+size_t Dted_Database::Get_Resident_Bytes() {
+    size_t residentBytes = 0;
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    vector<Dted_Cell*> cells;
+    for (int l = 0; l < NUM_LEVELS; l++)
+        levelStores[l]->Cell_Grid().Snapshot(cells);
+
+    for (size_t i = 0; i < cells.size(); i++) {
+        residentBytes += cells[i]->getResidentSize();
+
+        if (cells[i]->getOverview() != NULL)
+            residentBytes += cells[i]->getOverview()->Get_Size();
+
+        if (cells[i]->getMinMaxTree() != NULL)
+            residentBytes += cells[i]->getMinMaxTree()->Get_Size();
+    }
+
+    return residentBytes + pageCache.Get_Size();
+}
+
+bool Dted_Database::Load_Posts() const {
+    return (accessMethod == MEMORY_ACCESS)
+            || (accessMethod == COMPRESSED_ACCESS);
+}
+
+bool Dted_Database::Read_Resident(Dted_Level level,
+        const Geo_Location& geoLoc, Dted_Cell* dtedCellPtr) {
+    // The access method applies to cells loaded afterwards; a cell
+    // loaded before a change still holds its posts as loaded.
+    if (accessMethod != HYBRID_ACCESS)
+        return dtedCellPtr->isResident() || dtedCellPtr->isPaged();
+
+    // Promote once, when the count crosses the threshold, unless aging
+    // that has fallen due since takes it back under.
+    if ((dtedCellPtr->recordAccess() == promoteThreshold)
+            && !dtedCellPtr->isResident()) {
+        Enforce_Memory_Budget();
+
+        if (dtedCellPtr->getAccessCount() >= promoteThreshold)
+            Promote_Cell(level, geoLoc);
+    }
+
+    return dtedCellPtr->isResident();
+}
+
+void Dted_Database::Promote_Cell(Dted_Level level,
+        const Geo_Location& geoLoc) {
+    Dted_Directory* directory = Directory(level);
+
+    Dted_Cell_Loader::Load_Request request;
+    request.level = level;
+    request.loadPosts = true;
+
+    Dted_Cell_Grid::Cell_Corner(geoLoc, request.entry.latitude,
+            request.entry.longitude);
+
+    {
+        boost::mutex::scoped_lock lock(loadMutex);
+
+        if (!directory->Retrieve_Dted_Entry(request.entry))
+            return;
+    }
+
+    // Queries carry on from disk meanwhile.
+    Dted_Load_Handle handle = cellLoader.Begin_Batch();
+    cellLoader.Submit(handle, request, LOAD_PREFETCH);
+    cellLoader.Commit(handle);
+}
+
+namespace {
+
+//! A resident cell considered for demotion.
+struct Resident_Cell {
+    Dted_Level level;
+    Dted_Cell* cell;
+    unsigned int accessCount;
+    size_t residentSize;
+
+    bool operator<(const Resident_Cell& rhs) const {
+        return accessCount < rhs.accessCount;
+    }
+};
+
+}
+
+long long Dted_Database::Now_Ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void Dted_Database::Enforce_Memory_Budget(bool force) {
+    if (accessMethod != HYBRID_ACCESS)
+        return;
+
+    // Loads call this on every miss; most find nothing to do.
+    if (!force && (residentEstimate <= memoryBudget)
+            && (Now_Ms() - agedUntil < AGING_PERIOD_MS))
+        return;
+
+    boost::mutex::scoped_lock residencyLock(residencyMutex);
+
+    // Halve the counts once per elapsed period, whatever the load rate.
+    long long periods = (Now_Ms() - agedUntil) / AGING_PERIOD_MS;
+    int ageShift = (periods > 31) ? 31 : (int) periods;
+
+    agedUntil += periods * AGING_PERIOD_MS;
+
+    Dted_Epoch::Guard guard(cellEpoch);
+
+    vector<Resident_Cell> residentCells;
+    size_t residentBytes = 0;
+
+    for (int l = 0; l < NUM_LEVELS; l++) {
+        vector<Dted_Cell*> cells;
+        levelStores[l]->Cell_Grid().Snapshot(cells);
+
+        for (size_t i = 0; i < cells.size(); i++) {
+            Resident_Cell residentCell;
+            residentCell.level = levelStores[l]->Get_Level();
+            residentCell.cell = cells[i];
+            residentCell.accessCount = cells[i]->getAccessCount();
+            residentCell.residentSize = cells[i]->getResidentSize();
+
+            // Age the counts so that promotion needs recent queries.
+            if (ageShift > 0)
+                cells[i]->setAccessCount(
+                        residentCell.accessCount >> ageShift);
+
+            // Mapped posts cost no heap and are never demoted, nor are
+            // pinned ones.
+            if ((residentCell.residentSize == 0) || cells[i]->isPinned())
+                continue;
+
+            residentBytes += residentCell.residentSize;
+            residentCells.push_back(residentCell);
+        }
+    }
+
+    residentEstimate = residentBytes;
+
+    if (residentBytes <= memoryBudget)
+        return;
+
+    sort(residentCells.begin(), residentCells.end());
+
+    for (size_t i = 0; (i < residentCells.size())
+            && (residentBytes > memoryBudget); i++) {
+        const Resident_Cell& residentCell = residentCells[i];
+        Dted_Cell_Grid* cellGrid = Cell_Grid(residentCell.level);
+
+        Geo_Location cellCenter = residentCell.cell->getSwCornerPost();
+        cellCenter.lat += 0.5;
+        cellCenter.lon += 0.5;
+
+        Dted_Cell_Path_Entry dtedCellPathEntry;
+        Dted_Cell_Grid::Cell_Corner(cellCenter, dtedCellPathEntry.latitude,
+                dtedCellPathEntry.longitude);
+
+        {
+            boost::mutex::scoped_lock lock(loadMutex);
+
+            if (!Directory(residentCell.level)->Retrieve_Dted_Entry(
+                    dtedCellPathEntry))
+                continue;
+        }
+
+        Dted_Cell* dtedCellPtr = Create_Cell(dtedCellPathEntry, false);
+        dtedCellPtr->setAccessCount(residentCell.cell->getAccessCount());
+
+        if (cellGrid->Replace(dtedCellPathEntry.latitude,
+                dtedCellPathEntry.longitude, residentCell.cell,
+                dtedCellPtr)) {
+            cellEpoch.Retire(residentCell.cell,
+                    Dted_Epoch::Delete_Object<Dted_Cell>);
+            residentBytes -= residentCell.residentSize;
+        } else {
+            delete dtedCellPtr;
+        }
+    }
+
+    residentEstimate = residentBytes;
 }
 
@@ -15,10 +15,25 @@
 #ifndef Dted_Database_H
 #define Dted_Database_H
 
-#include <set>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "Dted_Async_Reader.h"
 #include "Dted_Cell.h"
+#include "Dted_Cell_Grid.h"
+#include "Dted_Cell_Loader.h"
 #include "Dted_Common.h"
+#include "Dted_Coverage.h"
 #include "Dted_Directory.h"
+#include "Dted_Epoch.h"
+#include "Dted_Page_Cache.h"
+#include "Dted_Query_Router.h"
+#include "Dted_Shared_Cache.h"
+#include "Dted_Tile_Store.h"
+#include "Dted_Tile_Arena.h"
+#include "Dted_Working_Set.h"
 
 using namespace std;
 
@@ -27,21 +42,29 @@ public:
 
     Dted_Database();
 
+    ~Dted_Database();
+
     //! Clear the contents of the Dted database.
     void Clear_Database();
 
-    /*! Populate Dted1 Directory with option to preload.
-     @param path directory path of Dted1 data.
-     @param preload Dted1 data into memory for fast access.
-     @return true if successful.
+    /*! Populate the Directory of a Dted level with option to preload.
+     @param level Dted level of the data.
+     @param path directory path of the data.
+     @param preload data into memory for fast access.
+     @return true if successful, false if the level is not supported.
      */
+    bool Populate_Directory(Dted_Level level, const string& path,
+            bool preLoad);
+
+    //! Populate Dted0 Directory with option to preload.  Level 0 cells
+    //! hold 121 x 121 posts, so the whole world stays resident in a few
+    //! hundred MB for coarse queries.
+    bool Populate_Dted0_Directory(const string& path, bool preLoad);
+
+    //! Populate Dted1 Directory with option to preload.
     bool Populate_Dted1_Directory(const string& path, bool preLoad);
 
-    /*! Populate Dted2 Directory with option to preload.
-     @param path directory path of Dted1 data.
-     @param preload Dted2 data into memory for fast access.
-     @return true if successful.
-     */
+    //! Populate Dted2 Directory with option to preload.
     bool Populate_Dted2_Directory(const string& path, bool preLoad);
 
     //! Retrieve a Dted geolocation elevation based on the current Dted
@@ -51,66 +74,547 @@ public:
     //! Retrieve a Dted post.
     double Get_Post_Elev(Geo_Location geoLoc, Voxel pointLoc);
 
+    /*! Retrieve a Dted geolocation elevation with the reason of a
+     missing one, so callers can tell sea level from no data.
+     @param elevation set to the elevation, 0.0 unless QUERY_OK.
+     @return QUERY_OK, QUERY_VOID_POST, QUERY_NO_COVERAGE,
+     QUERY_NOT_RESIDENT (real-time mode) or QUERY_OUT_OF_RANGE.
+     */
+    Query_Status Get_Geo_Elev(Geo_Location geoLoc, double& elevation);
+
+    //! Retrieve a Dted post with status like the above.  A post index
+    //! outside the cell is QUERY_OUT_OF_RANGE.
+    Query_Status Get_Post_Elev(Geo_Location geoLoc, Voxel pointLoc,
+            double& elevation);
+
+    /*! Retrieve a Dted geolocation elevation with per-call options
+     instead of the database settings.  Leaves the database and its
+     cells unchanged, so callers on different threads may use different
+     options.
+     @param options interpolation, level and null elevation.
+     @param elevation set to the elevation, options.nullElevation unless
+     QUERY_OK.
+     */
+    Query_Status Get_Geo_Elev(Geo_Location geoLoc,
+            const Query_Options& options, double& elevation);
+
+    //! Retrieve a Dted post with per-call options.
+    Query_Status Get_Post_Elev(Geo_Location geoLoc, Voxel pointLoc,
+            const Query_Options& options, double& elevation);
+
+    //! Options matching the database settings: the current Dted level,
+    //! bilinear interpolation if active, 0.0 for missing data, level
+    //! fallback if active and the query resolution.
+    Query_Options Get_Query_Options() const;
+
+    /*! Retrieve a geolocation elevation from the finest level that
+     answers it, trying options.level first and then each coarser level
+     whose coverage holds the location; a level with no coverage costs
+     no lookup.
+     @param elevation set to the elevation, options.nullElevation unless
+     QUERY_OK.
+     @param level set to the level that answered.
+     @return QUERY_OK, or the status of the finest level covering the
+     location (QUERY_NO_COVERAGE if none does).
+     */
+    Query_Status Get_Best_Geo_Elev(Geo_Location geoLoc,
+            const Query_Options& options, double& elevation,
+            Dted_Level& level);
+
+    //! Make the geolocation queries without Query_Options fall back to
+    //! coarser levels (see Get_Best_Geo_Elev()).
+    void Set_Level_Fallback_Active(bool newState);
+
+    /*! Retrieve a geolocation elevation from the coarsest level that
+     meets options.resolution, so that far-field queries run from small
+     resident cells and only near-field ones load the fine levels.  The
+     levels from LEVEL_0 up to options.level are tried in turn, skipping
+     those whose posts are farther apart than the resolution and those
+     without coverage; options.level is always tried.  With
+     options.levelFallback, the coarser levels are then tried as by
+     Get_Best_Geo_Elev().  Where the resolution allows, overviews of the
+     level answer (see Set_Overviews()).
+     @param elevation set to the elevation, options.nullElevation unless
+     QUERY_OK.
+     @param level set to the level that answered.
+     @return QUERY_OK, or the status of the coarsest level tried
+     (QUERY_NO_COVERAGE if none was).
+     */
+    Query_Status Get_Lod_Geo_Elev(Geo_Location geoLoc,
+            const Query_Options& options, double& elevation,
+            Dted_Level& level);
+
+    //! Ground resolution, in meters, of the geolocation queries without
+    //! Query_Options (see Get_Lod_Geo_Elev()); 0.0 to query the current
+    //! level.
+    void Set_Query_Resolution(double meters);
+
+    /*! Answer the queries whose resolution allows it from overviews of
+     the level's cells (see Dted_Overview), each built on the first such
+     query of its cell and kept with the cell.  The overview used is the
+     coarsest whose spacing, 2^k times the level's, meets the resolution;
+     Query_Options::overview selects its mode.
+     @param levels overview levels built per cell, 0 for none.
+     @param modes Overview_Mode values or'ed together; overviews already
+     built keep their settings.
+     */
+    void Set_Overviews(int levels, unsigned int modes);
+
+    //! Returns true if the directory of a level holds the cell of a
+    //! location, whether loaded or not.
+    bool Has_Coverage(Dted_Level level, Geo_Location geoLoc) const;
+
+    /*! Retrieve the elevations of many geolocations.  With NUMA
+     placement the queries run on threads of the node holding each
+     location's cell, otherwise on the calling thread.
+     @param locations geolocations to query.
+     @param elevations set to the elevation of each location.
+     */
+    void Get_Geo_Elevs(const vector<Geo_Location>& locations,
+            vector<double>& elevations);
+
+    //! Retrieve the elevations of many geolocations with per-call
+    //! options.
+    void Get_Geo_Elevs(const vector<Geo_Location>& locations,
+            const Query_Options& options, vector<double>& elevations);
+
+    /*! Retrieve the highest post of a region at the current Dted level,
+     e.g. for obstacle clearance.  Each cell of the region builds a
+     min/max hierarchy of its posts on first use (see
+     Dted_Min_Max_Tree), so that only the blocks which can raise the
+     answer are visited.  Cells without coverage are skipped.  Real-time
+     queries only read resident cells and build no hierarchy.
+     @param box region, posts on its edges included.
+     @param elevation set to the highest non void post, 0.0 unless
+     QUERY_OK.
+     @return QUERY_OK, QUERY_VOID_POST if the covered cells hold no non
+     void post in the region, QUERY_NO_COVERAGE if no cell covers it,
+     QUERY_NOT_RESIDENT if a real-time query met a covered cell not
+     resident, or QUERY_OUT_OF_RANGE for an invalid box.
+     */
+    Query_Status Get_Region_Max(const Geo_Box& box, double& elevation);
+
+    //! Retrieve the highest post of a region with per-call options;
+    //! options.level selects the cells.
+    Query_Status Get_Region_Max(const Geo_Box& box,
+            const Query_Options& options, double& elevation);
+
+    //! Retrieve the lowest post of a region (see Get_Region_Max()).
+    Query_Status Get_Region_Min(const Geo_Box& box, double& elevation);
+
+    //! Retrieve the lowest post of a region with per-call options.
+    Query_Status Get_Region_Min(const Geo_Box& box,
+            const Query_Options& options, double& elevation);
+
+    /*! Retrieve a geolocation elevation at the current Dted level
+     from a cell already in memory.  Never loads, allocates, locks, logs
+     or does I/O once the calling thread is registered with
+     Register_Real_Time_Thread().
+     @param elevation set to the elevation, 0.0 unless QUERY_OK.
+     @return QUERY_NOT_RESIDENT if the cell is covered but not loaded
+     with direct posts (see Pin_Region()), else as Get_Geo_Elev().
+     */
+    Query_Status Get_Resident_Geo_Elev(Geo_Location geoLoc,
+            double& elevation);
+
+    //! Retrieve a post like Get_Resident_Geo_Elev().
+    Query_Status Get_Resident_Post_Elev(Geo_Location geoLoc,
+            Voxel pointLoc, double& elevation);
+
+    //! Get_Resident_Geo_Elev() with per-call options.
+    Query_Status Get_Resident_Geo_Elev(Geo_Location geoLoc,
+            const Query_Options& options, double& elevation);
+
+    //! Get_Resident_Post_Elev() with per-call options.
+    Query_Status Get_Resident_Post_Elev(Geo_Location geoLoc,
+            Voxel pointLoc, const Query_Options& options,
+            double& elevation);
+
+    /*! Load the cells of a region with their posts uncompressed in
+     memory, whatever the access method, fault them in and keep them
+     from HYBRID_ACCESS demotion.  Unload_Cell() and Reload_Cell() still
+     apply to pinned cells.
+     @param box region to pin; rejected unless both corners are valid
+     locations and the south west one is south and west of the other.
+     @param level Dted level of the cells.
+     @param lockMemory also mlock the posts; needs a sufficient
+     RLIMIT_MEMLOCK.
+     @return true if every cell of the region in the directory was
+     pinned, false for an invalid box.
+     */
+    bool Pin_Region(const Geo_Box& box, Dted_Level level,
+            bool lockMemory = false);
+
+    //! Serve Get_Geo_Elev(), Get_Post_Elev() and Get_Geo_Elevs() like
+    //! Get_Resident_Geo_Elev(): cells not resident read as 0.0 instead
+    //! of being loaded.
+    void Set_Real_Time_Active(bool newState);
+
+    //! Register the calling thread for queries ahead of time, so that
+    //! its first query does not allocate.  Callers must check the
+    //! result: on an unregistered thread the real-time queries report
+    //! QUERY_NOT_RESIDENT while Dted_Epoch::MAX_READERS other threads
+    //! query the database, and the other queries wait for one to exit.
+    //! @return false if too many threads query the database.
+    bool Register_Real_Time_Thread();
+
+    //! Gather statistics for the loaded cells of a Dted level
+    void Gather_Stats(Dted_Level level);
+
+    //! Gather statistics for Dted0 Directory
+    void Gather_Stats_Dted0();
+
     //! Gather statistics for Dted1 Directory
     void Gather_Stats_Dted1();
 
     //! Gather statistics for Dted2 Directory
     void Gather_Stats_Dted2();
 
-    //! Enable/Disable bilinear intepolation
+    //! Enable/Disable bilinear intepolation of the queries without
+    //! Query_Options
     void Set_Bilinear_Interp_Active(bool newState);
 
-    //! Set the Access_Method for DTED data to either DISK_ACCESS or
-    //! MEMORY_ACCESS.
+    //! Set the Access_Method for DTED data to DISK_ACCESS, MEMORY_ACCESS,
+    //! COMPRESSED_ACCESS, HYBRID_ACCESS or PAGED_ACCESS.  Applies to
+    //! cells loaded afterwards.
     void Set_Access_Method(Access_Method newMethod);
 
-    //! Retrieves the Access_Method for DTED data.  Returns either
-    //! DISK_ACCESS or MEMORY_ACCESS.
+    //! Retrieves the Access_Method for DTED data.  Returns DISK_ACCESS,
+    //! MEMORY_ACCESS, COMPRESSED_ACCESS, HYBRID_ACCESS or PAGED_ACCESS.
     Access_Method Get_Access_Method() const;
 
+    /*! Share the decoded cells with the other processes of the node
+     through a cache directory (see Dted_Shared_Cache).  Cells whose
+     posts are loaded afterwards are mapped from the cache, decoding
+     them into it if no process has.
+     Set it before querying.
+     @param directory cache directory, e.g. "/dev/shm/dted"; an empty
+     path stops sharing.
+     @return true if the cache directory can be used.
+     */
+    bool Set_Shared_Cache(const string& directory);
+
+    /*! Allocate the posts of cells loaded afterwards from a huge page
+     backed arena (see Dted_Tile_Arena) rather than one heap block per
+     cell, which cuts TLB misses on random lookups over many cells.
+     @param newState use the arena.
+     @param hugeTlb map the arena with MAP_HUGETLB; needs huge pages
+     reserved by the system, else transparent huge pages are used.
+     */
+    void Set_Tile_Arena_Active(bool newState, bool hugeTlb = false);
+
+    /*! Place the posts of cells loaded afterwards on NUMA nodes, from a
+     tile arena per node, and route Get_Geo_Elevs() queries to the
+     nodes.  Set it before loading cells.
+     @param placement NUMA_NONE, NUMA_INTERLEAVE or NUMA_SPATIAL.
+     */
+    void Set_Numa_Placement(Numa_Placement placement);
+
+    //! Set the number of Get_Geo_Elevs() threads per NUMA node.
+    void Set_Query_Threads_Per_Node(int threadsPerNode);
+
+    //! Set the bytes of decoded posts the PAGED_ACCESS page cache keeps.
+    void Set_Page_Cache_Size(size_t bytes);
+
+    /*! Set the memory budget of HYBRID_ACCESS.  When the resident posts
+     exceed it, the least queried resident cells are demoted to disk
+     access.
+     @param bytes budget of the resident posts.
+     */
+    void Set_Memory_Budget(size_t bytes);
+
+    //! Set the number of queries after which HYBRID_ACCESS loads a cell's
+    //! posts into memory.  Query counts are halved every second, so only
+    //! recently hot cells are promoted.
+    void Set_Promote_Threshold(unsigned int accesses);
+
+    //! Heap bytes held by the resident posts of the loaded cells and by
+    //! the page cache.
+    size_t Get_Resident_Bytes();
+
     //! Set the current DTED level
     void Set_Dted_Level(Dted_Level newDtedLevel);
 
     //! Returns the current DTED level
     Dted_Level Get_Dted_Level();
 
+    /*! Unload a cell while queries may be running on other threads.
+     The cell is freed once no query can still be reading it.
+     @param level Dted level of the cell.
+     @param latitude south west corner latitude of the cell.
+     @param longitude south west corner longitude of the cell.
+     @return true if a loaded cell was removed.
+     */
+    bool Unload_Cell(Dted_Level level, short latitude, short longitude);
+
+    /*! Replace a loaded cell with a freshly read copy of its file, e.g.
+     after the file was updated on disk.  Queries keep using the old
+     cell until the new one is published.
+     @return true if the cell exists in the directory and was reloaded.
+     */
+    bool Reload_Cell(Dted_Level level, short latitude, short longitude);
+
+    /*! Load the cells intersecting a region on background threads.
+     Returns immediately; queries made meanwhile load any cell they
+     need themselves.
+     @param box region of interest.
+     @param level Dted level of the cells to load.
+     @return handle to wait for or cancel the loads.
+     */
+    Dted_Load_Handle Prefetch_Region(const Geo_Box& box, Dted_Level level);
+
+    /*! Load the cells covering a list of locations on background threads,
+     in list order.
+     @param locations locations whose cells are wanted.
+     @param level Dted level of the cells to load.
+     @param priority LOAD_PREFETCH, or LOAD_SPECULATIVE for guesses.
+     @return handle to wait for or cancel the loads.
+     */
+    Dted_Load_Handle Prefetch_Cells(const vector<Geo_Location>& locations,
+            Dted_Level level, Load_Priority priority = LOAD_PREFETCH);
+
+    //! Set the number of background loader threads; takes effect at
+    //! once, also while loads are running.
+    void Set_Loader_Threads(int threadCount);
+
+    //! Set the number of concurrent background loads per storage device.
+    void Set_Device_Concurrency(int deviceConcurrency);
+
+    //! Free unloaded cells that no query can still be reading.
+    void Reclaim_Cells();
+
+    //! Start or stop recording the cells queried (see Dted_Working_Set).
+    //! Starting forgets the cells recorded before.
+    void Set_Working_Set_Recording(bool newState);
+
+    //! Write the cells recorded so far, in first query order with their
+    //! query counts.
+    //! @return true if the file was written.
+    bool Save_Working_Set(const string& path);
+
+    /*! Load the cells of a working set file on the background loaders,
+     in the recorded order, and wait for them.  Call it after populating
+     the directories and before querying to start warm.
+     @return true if the file was read.
+     */
+    bool Preload_Working_Set(const string& path);
+
+    /*! Write the directories and the loaded cells to a snapshot file
+     (see Dted_Snapshot_Format.h).
+     @param path snapshot to write; replaced atomically.
+     @return true if the snapshot was written.
+     */
+    bool Save_Snapshot(const string& path);
+
+    /*! Replace the contents of the database by a snapshot.  The cells
+     of the snapshot are mapped from it rather than read from their Dted
+     files; other cells load from the restored directories as usual.
+     @return true if the snapshot was restored.
+     */
+    bool Load_Snapshot(const string& path);
+
+    //! Number of cells currently loaded for a level.
+    int Get_Loaded_Cell_Count(Dted_Level level) const;
+
 private:
 
-    Dted_Directory dted1_dir;
-    Dted_Directory dted2_dir;
+    enum {
+        NUM_LEVELS = LEVEL_2 + 1
+    };
+
+    //! Directory, lock-free index of the loaded DTED Cells and coverage
+    //! of each level.
+    Dted_Tile_Store<Dted_Level_Traits<LEVEL_0> > dted0Store;
+    Dted_Tile_Store<Dted_Level_Traits<LEVEL_1> > dted1Store;
+    Dted_Tile_Store<Dted_Level_Traits<LEVEL_2> > dted2Store;
+
+    //! The stores indexed by Dted_Level.
+    Dted_Level_Store* levelStores[NUM_LEVELS];
 
     //! The current dted level.
     Dted_Level dtedLevel;
 
-    typedef std::set<Dted_Cell*> Dted_Cell_Set;
+    //! Pages of the PAGED_ACCESS cells.  Outlives cellEpoch, whose
+    //! destruction frees the last retired cells.
+    Dted_Page_Cache pageCache;
 
-    //! STL containers for DTED Cells.
-    Dted_Cell_Set dted1CellSet;
-    Dted_Cell_Set dted2CellSet;
+    //! Posts of the cells loaded while tileArenaActive.  Outlives
+    //! cellEpoch like pageCache.
+    Dted_Tile_Arena tileArena;
+    bool tileArenaActive;
+    bool tileArenaHugeTlb;
+
+    //! Tile arena of each NUMA node, used under NUMA placement.
+    vector<boost::shared_ptr<Dted_Tile_Arena> > nodeArenas;
+    Numa_Placement numaPlacement;
+
+    //! Runs Get_Geo_Elevs() under NUMA placement.
+    Dted_Query_Router queryRouter;
+
+    //! Cells shared with the other processes of the node.
+    Dted_Shared_Cache sharedCache;
+
+    //! Defers freeing of unloaded cells until no query can hold them.
+    Dted_Epoch cellEpoch;
+
+    //! Guards directory lookups and the failed lookup cache; queries on
+    //! loaded cells never take it.
+    boost::mutex loadMutex;
+
+    //! Batch reader of each loader thread, set up on its first batch and
+    //! kept for the life of the thread.  Declared before cellLoader so
+    //! that the loader threads exit before it is destroyed.
+    boost::thread_specific_ptr<Dted_Async_Reader> batchReader;
+
+    //! Schedules foreground, prefetch and preload cell loads.
+    Dted_Cell_Loader cellLoader;
 
     Dted_Cell_Path_Entry prevFailedCellPathEntry;
 
     bool bilinearInterpActive;
+    bool levelFallbackActive;
+
+    //! Ground resolution of the queries without Query_Options.
+    double queryResolution;
+
+    //! Overviews built for the cells.
+    int overviewLevels;
+    unsigned int overviewModes;
 
-    // Previous cell iterator - attempt to use last found cell to avoid
-    // researching through all cells
-    Dted_Cell_Set::const_iterator prevCellItDted1;
-    Dted_Cell_Set::const_iterator prevCellItDted2;
+    //! Queries never load (see Set_Real_Time_Active()).
+    bool realTimeActive;
+
+    //! Cells queried while recordingActive.
+    Dted_Working_Set workingSet;
+    bool recordingActive;
 
     //! Defines the access method.
     Access_Method accessMethod;
 
-    //! Retrieve a Dted1 geolocation.
-    double Get_Geo_Elev_Dted1(Geo_Location geoLoc);
+    enum {
+        DEFAULT_PROMOTE_THRESHOLD = 256,
+        AGING_PERIOD_MS = 1000 // Query counts halve once per period
+    };
+
+    //! HYBRID_ACCESS residency settings.
+    size_t memoryBudget;
+    unsigned int promoteThreshold;
+
+    //! Resident bytes found by the last budget scan plus the bytes
+    //! promoted since; the next scan corrects any drift.
+    boost::atomic<size_t> residentEstimate;
+
+    //! Monotonic time (ms) up to which the query counts are aged.
+    boost::atomic<long long> agedUntil;
 
-    //! Retrieve a Dted1 post.
-    double Get_Post_Elev_Dted1(Geo_Location geoLoc, Voxel pointLoc);
+    //! Serializes HYBRID_ACCESS demotions.
+    boost::mutex residencyMutex;
 
-    //! Retrieve a Dted2 geolocation.
-    double Get_Geo_Elev_Dted2(Geo_Location geoLoc);
+    //! NUMA node of a cell under the current placement.
+    int Cell_Node(short latitude, short longitude) const;
 
-    //! Retrieve a Dted2 post.
-    double Get_Post_Elev_Dted2(Geo_Location geoLoc, Voxel pointLoc);
+    //! Returns true if loads under the access method read the posts.
+    bool Load_Posts() const;
+
+    //! Returns true if a query of the cell is served from its resident
+    //! or paged posts rather than read from its file, whatever the
+    //! method it was loaded under.  Under HYBRID_ACCESS, counts the
+    //! query and promotes the cell once it is hot.
+    bool Read_Resident(Dted_Level level, const Geo_Location& geoLoc,
+            Dted_Cell* dtedCellPtr);
+
+    //! Queue a background load of the posts of a cell on disk access.
+    void Promote_Cell(Dted_Level level, const Geo_Location& geoLoc);
+
+    /*! Demote the least queried resident cells until the resident posts
+     fit the memory budget, and age the query counts once per
+     AGING_PERIOD_MS.  Scans the loaded cells only when an aging period
+     has passed or the resident estimate exceeds the budget.  Only acts
+     under HYBRID_ACCESS.
+     @param force scan even if neither is due.
+     */
+    void Enforce_Memory_Budget(bool force = false);
+
+    //! Monotonic milliseconds.
+    static long long Now_Ms();
+
+    //! Returns the store of a Dted level, NULL if not supported.
+    Dted_Level_Store* Store(Dted_Level level);
+    const Dted_Level_Store* Store(Dted_Level level) const;
+
+    //! Returns the cell grid of a Dted level, NULL if not supported.
+    Dted_Cell_Grid* Cell_Grid(Dted_Level level);
+    const Dted_Cell_Grid* Cell_Grid(Dted_Level level) const;
+
+    //! Returns the directory of a Dted level, NULL if not supported.
+    Dted_Directory* Directory(Dted_Level level);
+
+    //! Returns the coverage of a Dted level, NULL if not supported.
+    Dted_Coverage* Coverage(Dted_Level level);
+    const Dted_Coverage* Coverage(Dted_Level level) const;
+
+    //! Rebuild the coverage of a level from its directory.
+    void Update_Coverage(Dted_Level level);
+
+    //! Load the cell covering geoLoc from the level's directory and
+    //! publish it.  Must be called under a cellEpoch guard.
+    //! @return the cell, or NULL if the directory has no coverage.
+    Dted_Cell* Load_Cell(Dted_Level level, const Geo_Location& geoLoc);
+
+    //! Create a cell for a directory entry.
+    //! @param loadPosts load the posts into memory.
+    //! @param allowCompression compress the posts under
+    //! COMPRESSED_ACCESS.
+    Dted_Cell* Create_Cell(const Dted_Cell_Path_Entry& dtedCellPathEntry,
+            bool loadPosts, bool allowCompression = true);
+
+    //! Load a cell with direct posts if needed and pin it.
+    //! @return false if a cell in the directory could not be pinned.
+    bool Pin_Cell(Dted_Level level, short latitude, short longitude,
+            bool lockMemory);
+
+    //! Queue a background load of a cell unless loaded or unknown.
+    void Submit_Prefetch(Dted_Load_Handle& handle, Dted_Level level,
+            short latitude, short longitude, Load_Priority priority);
+
+    //! Preload every cell of a level's directory.
+    void Preload_Directory(Dted_Level level);
+
+    //! Loader callback: load and publish the requested cell.
+    bool Load_Requested_Cell(const Dted_Cell_Loader::Load_Request& request);
+
+    //! Loader callback: load and publish several cells, reading their
+    //! posts with all reads in flight at once.
+    void Load_Requested_Cells(
+            const vector<Dted_Cell_Loader::Load_Request>& requests,
+            vector<bool>& loaded);
+
+    //! Returns true if a geolocation is a valid latitude and longitude.
+    static bool Is_Valid_Location(const Geo_Location& geoLoc);
+
+    //! Retrieve a geolocation from the cells of a level.  The level
+    //! functions only set elevation on QUERY_OK.
+    Query_Status Get_Level_Geo_Elev(Dted_Level_Store& store,
+            Geo_Location geoLoc, Interpolation_Mode interpolation,
+            double& elevation);
+
+    //! Retrieve the highest (or lowest) post of a region.
+    Query_Status Get_Region_Post(const Geo_Box& box,
+            const Query_Options& options, bool findMax, double& elevation);
+
+    //! Coarsest overview level meeting a resolution, 0 for none.
+    int Overview_Level(const Dted_Level_Store& store,
+            double resolution) const;
+
+    //! Retrieve a geolocation from an overview of the cells of a level,
+    //! or at full resolution if the cell has no such overview.
+    Query_Status Get_Overview_Geo_Elev(Dted_Level_Store& store,
+            Geo_Location geoLoc, int overviewLevel,
+            const Query_Options& options, double& elevation);
+
+    //! Retrieve a post from the cells of a level.
+    Query_Status Get_Level_Post_Elev(Dted_Level_Store& store,
+            Geo_Location geoLoc, Voxel pointLoc, double& elevation);
 
     bool debug;
 };
@@ -15,9 +15,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <dirent.h>
 #include <sys/stat.h>
 
+#include <map>
+
+#include "Dted_Archive.h"
 #include "Dted_Directory.h"
 
 #if defined(WIN32)
@@ -33,6 +37,10 @@ Dted_Directory::Dted_Directory() :
 }
 
 bool Dted_Directory::Populate_Directory(const string& pathName) {
+    // A single file archive holds its own index.
+    if (Dted_Archive::Is_Archive(pathName))
+        return Populate_Archive(pathName);
+
     // Open the directory.
 
     DIR *The_Directory = opendir(pathName.c_str());
@@ -143,7 +151,16 @@ bool Dted_Directory::Populate_Directory(const string& pathName) {
                     cout << "Path = " << path_Entry.cellPath << endl << endl;
                 }
 
-                pathEntrySet.insert(path_Entry);
+                pair<Path_Entry_Set::iterator, bool> inserted =
+                        pathEntrySet.insert(path_Entry);
+
+                // A packed cell takes precedence over the Dted file it was
+                // converted from.
+                if (!inserted.second
+                        && Is_Packed_File(Directory_Entry->d_name)) {
+                    pathEntrySet.erase(inserted.first);
+                    pathEntrySet.insert(path_Entry);
+                }
             }
         }
 
@@ -231,19 +248,44 @@ bool Dted_Directory::Populate_Directory(const string& pathName) {
     return Found;
 }
 
+bool Dted_Directory::Populate_Archive(const string& pathName) {
+    boost::shared_ptr<Dted_Archive> archive(new Dted_Archive());
+
+    if (!archive->Open(pathName)) {
+        cout << "WARNING> Invalid DTED archive: '" << pathName << "'" << endl;
+        return false;
+    }
+
+    for (int i = 0; i < archive->Get_Cell_Count(); i++) {
+        const Dted_Archive::Index_Entry& entry = archive->Get_Entry(i);
+
+        Dted_Cell_Path_Entry path_Entry;
+        path_Entry.latitude = entry.latitude;
+        path_Entry.longitude = entry.longitude;
+        path_Entry.cellPath = pathName;
+        path_Entry.archive = archive;
+
+        // Loose cells found earlier take precedence.
+        pathEntrySet.insert(path_Entry);
+    }
+
+    if (debug)
+        cout << "Added " << archive->Get_Cell_Count()
+                << " DTED cells from archive " << pathName << endl;
+
+    return archive->Get_Cell_Count() > 0;
+}
+
 bool Dted_Directory::Retrieve_Dted_Entry(
         Dted_Cell_Path_Entry &dted_Cell_Path_Entry) {
-    Path_Entry_Set::const_iterator it = pathEntrySet.begin();
+    Path_Entry_Set::const_iterator it = pathEntrySet.find(dted_Cell_Path_Entry);
 
-    while (it != pathEntrySet.end()) {
-        if (*it == dted_Cell_Path_Entry) {
-            dted_Cell_Path_Entry = *it;
-            return true;
-        }
-        it++;
-    }
+    if (it == pathEntrySet.end())
+        return false;
 
-    return false;
+    dted_Cell_Path_Entry = *it;
+
+    return true;
 }
 
 void Dted_Directory::Clear_Dted_Directory() {
@@ -257,6 +299,128 @@ void Dted_Directory::Clear_Dted_Directory() {
     pathEntrySet.clear();
 }
 
+namespace {
+
+void Write_String(ostream& directoryStr, const string& text) {
+    unsigned int length = text.length();
+
+    directoryStr.write((const char*) &length, sizeof(length));
+    directoryStr.write(text.data(), length);
+}
+
+bool Read_String(const char*& data, const char* end, string& text) {
+    unsigned int length;
+
+    if ((size_t) (end - data) < sizeof(length))
+        return false;
+
+    memcpy(&length, data, sizeof(length));
+    data += sizeof(length);
+
+    if ((size_t) (end - data) < length)
+        return false;
+
+    text.assign(data, length);
+    data += length;
+
+    return true;
+}
+
+}
+
+bool Dted_Directory::Save_Directory(ostream& directoryStr) const {
+    unsigned int entryCount = pathEntrySet.size();
+
+    Write_String(directoryStr, minMeridian);
+    Write_String(directoryStr, maxMeridian);
+    Write_String(directoryStr, minParallel);
+    Write_String(directoryStr, maxParallel);
+
+    directoryStr.write((const char*) &entryCount, sizeof(entryCount));
+
+    Path_Entry_Set::const_iterator it = pathEntrySet.begin();
+
+    while (it != pathEntrySet.end()) {
+        char archived = it->archive ? 1 : 0;
+
+        directoryStr.write((const char*) &it->latitude, sizeof(it->latitude));
+        directoryStr.write((const char*) &it->longitude,
+                sizeof(it->longitude));
+        directoryStr.write(&archived, sizeof(archived));
+        Write_String(directoryStr, it->cellPath);
+        it++;
+    }
+
+    return directoryStr.good();
+}
+
+bool Dted_Directory::Restore_Directory(const char* data, size_t size) {
+    const char* end = data + size;
+    unsigned int entryCount;
+
+    Clear_Dted_Directory();
+
+    if (!Read_String(data, end, minMeridian)
+            || !Read_String(data, end, maxMeridian)
+            || !Read_String(data, end, minParallel)
+            || !Read_String(data, end, maxParallel)
+            || ((size_t) (end - data) < sizeof(entryCount))) {
+        Clear_Dted_Directory();
+        return false;
+    }
+
+    memcpy(&entryCount, data, sizeof(entryCount));
+    data += sizeof(entryCount);
+
+    // Map each archive once for all of its entries.
+    map<string, boost::shared_ptr<Dted_Archive> > archives;
+
+    for (unsigned int i = 0; i < entryCount; i++) {
+        Dted_Cell_Path_Entry path_Entry;
+        char archived;
+
+        if ((size_t) (end - data)
+                < sizeof(path_Entry.latitude) + sizeof(path_Entry.longitude)
+                        + sizeof(archived)) {
+            Clear_Dted_Directory();
+            return false;
+        }
+
+        memcpy(&path_Entry.latitude, data, sizeof(path_Entry.latitude));
+        data += sizeof(path_Entry.latitude);
+        memcpy(&path_Entry.longitude, data, sizeof(path_Entry.longitude));
+        data += sizeof(path_Entry.longitude);
+        archived = *data++;
+
+        if (!Read_String(data, end, path_Entry.cellPath)) {
+            Clear_Dted_Directory();
+            return false;
+        }
+
+        if (archived) {
+            boost::shared_ptr<Dted_Archive>& archive =
+                    archives[path_Entry.cellPath];
+
+            if (!archive) {
+                archive.reset(new Dted_Archive());
+
+                if (!archive->Open(path_Entry.cellPath))
+                    cout << "WARNING> Invalid DTED archive: '"
+                            << path_Entry.cellPath << "'" << endl;
+            }
+
+            if (archive->Get_Cell_Count() == 0)
+                continue;
+
+            path_Entry.archive = archive;
+        }
+
+        pathEntrySet.insert(path_Entry);
+    }
+
+    return true;
+}
+
 void Dted_Directory::Dump_Path_Entry_Set() {
     Path_Entry_Set::const_iterator it = pathEntrySet.begin();
 
@@ -281,7 +445,17 @@ bool Dted_Directory::Is_Dted_File(string fileName) {
             || (fileName.compare("dT2") == 0) || (fileName.compare("dt2") == 0))
         return true;
     else
-        return false;
+        return Is_Packed_File(fileName);
+}
+
+bool Dted_Directory::Is_Packed_File(string fileName) {
+    // Erase the filename up to the last '.' to obtain extension
+    fileName.erase(0, fileName.find_last_of('.') + 1);
+
+    for (size_t i = 0; i < fileName.length(); i++)
+        fileName[i] = tolower(fileName[i]);
+
+    return fileName.compare("dtp") == 0;
 }
 
 void Dted_Directory::QueryReset(void) {
@@ -29,7 +29,8 @@ public:
     Dted_Directory();
 
     //! Populates the Dted_Directory with DTED entries.  The DTED entries
-    //! are generated from the path passed in as an input variable.
+    //! are generated from the path passed in as an input variable, which
+    //! is either a directory tree or a Dted_Archive file.
     bool Populate_Directory(const string& path);
 
     //! Displays all of the entries in the DTED directory.
@@ -47,6 +48,16 @@ public:
     //! Clear the contents of the Dted Directory
     void Clear_Dted_Directory();
 
+    //! Write the entries and bounds of the directory to a stream.
+    //! @return Returns true on success, false on error.
+    bool Save_Directory(ostream& directoryStr) const;
+
+    /*! Replace the contents of the directory by entries written with
+     Save_Directory().  Archives of archived entries are mapped again.
+     @return Returns true on success, false if the data is invalid.
+     */
+    bool Restore_Directory(const char* data, size_t size);
+
     //! Return the minimum meridian for the Minimun Bounding Rectangle(MBR)
     string getMinMeridian();
 
@@ -60,8 +71,14 @@ public:
     string getMaxParallel();
 
 private:
+    //! Populates the Dted_Directory with the index of an archive.
+    bool Populate_Archive(const string& path);
+
     //! Returns true if a filename contains a DTED extension.
     bool Is_Dted_File(string fileName);
+
+    //! Returns true if a filename contains the packed cell extension.
+    bool Is_Packed_File(string fileName);
     short currPathMeridian;
     string minMeridian;
     string maxMeridian;
@@ -0,0 +1,209 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Epoch based reclamation for objects shared between
+//               lock-free readers and a writer that unlinks them.
+//
+//********************************************************************
+
+#include <boost/thread/thread.hpp>
+
+#include "Dted_Epoch.h"
+
+Dted_Epoch::Guard::Guard(Dted_Epoch& epoch, bool wait) :
+        theEpoch(epoch),
+        entered(true) {
+    if (wait)
+        theEpoch.Enter();
+    else
+        entered = theEpoch.Try_Enter();
+}
+
+Dted_Epoch::Guard::~Guard() {
+    if (entered)
+        theEpoch.Exit();
+}
+
+bool Dted_Epoch::Guard::Is_Entered() const {
+    return entered;
+}
+
+Dted_Epoch::Reader_Table::Reader_Table() {
+    for (int i = 0; i < MAX_READERS; i++) {
+        slots[i].epoch.store(0);
+        slots[i].inUse.store(false);
+        slots[i].depth = 0;
+    }
+}
+
+Dted_Epoch::Reader_Slot* Dted_Epoch::Reader_Table::Try_Acquire() {
+    for (int i = 0; i < MAX_READERS; i++) {
+        bool expected = false;
+
+        if (slots[i].inUse.compare_exchange_strong(expected, true))
+            return &slots[i];
+    }
+
+    return NULL;
+}
+
+Dted_Epoch::Slot_Handle::~Slot_Handle() {
+    slot->epoch.store(0);
+    slot->depth = 0;
+    slot->inUse.store(false);
+
+    // Notified under the lock so that a waiter scanning the slots under
+    // it cannot miss the release.
+    boost::mutex::scoped_lock lock(table->slotMutex);
+    table->slotReleased.notify_all();
+}
+
+Dted_Epoch::Dted_Epoch() :
+        globalEpoch(1),
+        readerTable(new Reader_Table()) {
+}
+
+Dted_Epoch::~Dted_Epoch() {
+    boost::mutex::scoped_lock lock(retiredMutex);
+
+    for (size_t i = 0; i < retiredObjects.size(); i++)
+        retiredObjects[i].deleter(retiredObjects[i].object);
+
+    retiredObjects.clear();
+}
+
+Dted_Epoch::Reader_Slot* Dted_Epoch::Acquire_Slot(bool wait) {
+    Slot_Handle* handle = threadSlot.get();
+
+    // A handle left behind by an earlier instance at the same address
+    // refers to a table nobody scans anymore.
+    if ((handle != NULL) && (handle->table == readerTable))
+        return handle->slot;
+
+    Reader_Slot* slot = readerTable->Try_Acquire();
+
+    if ((slot == NULL) && wait) {
+        // Every slot is owned; wait for a reader thread to exit.
+        boost::mutex::scoped_lock lock(readerTable->slotMutex);
+
+        while ((slot = readerTable->Try_Acquire()) == NULL)
+            readerTable->slotReleased.wait(lock);
+    }
+
+    if (slot == NULL)
+        return NULL;
+
+    handle = new Slot_Handle();
+    handle->table = readerTable;
+    handle->slot = slot;
+    threadSlot.reset(handle);
+
+    return slot;
+}
+
+bool Dted_Epoch::Register_Thread() {
+    return Acquire_Slot(false) != NULL;
+}
+
+void Dted_Epoch::Enter() {
+    Reader_Slot* slot = Acquire_Slot(true);
+
+    if (slot->depth++ == 0)
+        slot->epoch.store(globalEpoch.load());
+}
+
+bool Dted_Epoch::Try_Enter() {
+    Reader_Slot* slot = Acquire_Slot(false);
+
+    if (slot == NULL)
+        return false;
+
+    if (slot->depth++ == 0)
+        slot->epoch.store(globalEpoch.load());
+
+    return true;
+}
+
+void Dted_Epoch::Exit() {
+    Reader_Slot* slot = threadSlot.get()->slot;
+
+    if (--slot->depth == 0)
+        slot->epoch.store(0);
+}
+
+void Dted_Epoch::Retire(void* object, Deleter deleter) {
+    Retired_Object retired;
+
+    retired.object = object;
+    retired.deleter = deleter;
+
+    // Readers entering after this increment can no longer reach the
+    // (already unlinked) object.
+    retired.epoch = globalEpoch.fetch_add(1) + 1;
+
+    bool collect;
+    {
+        boost::mutex::scoped_lock lock(retiredMutex);
+        retiredObjects.push_back(retired);
+        collect = retiredObjects.size() >= COLLECT_THRESHOLD;
+    }
+
+    if (collect)
+        Collect();
+}
+
+unsigned long Dted_Epoch::Min_Active_Epoch() const {
+    unsigned long minEpoch = ~0UL;
+
+    for (int i = 0; i < MAX_READERS; i++) {
+        unsigned long epoch = readerTable->slots[i].epoch.load();
+
+        if ((epoch != 0) && (epoch < minEpoch))
+            minEpoch = epoch;
+    }
+
+    return minEpoch;
+}
+
+void Dted_Epoch::Collect() {
+    vector<Retired_Object> reclaimable;
+    {
+        boost::mutex::scoped_lock lock(retiredMutex);
+
+        unsigned long minEpoch = Min_Active_Epoch();
+        vector<Retired_Object>::iterator it = retiredObjects.begin();
+
+        while (it != retiredObjects.end()) {
+            if (it->epoch <= minEpoch) {
+                reclaimable.push_back(*it);
+                it = retiredObjects.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    // Run the deleters outside of the lock.
+    for (size_t i = 0; i < reclaimable.size(); i++)
+        reclaimable[i].deleter(reclaimable[i].object);
+}
+
+void Dted_Epoch::Synchronize() {
+    Collect();
+
+    while (Pending() > 0) {
+        boost::this_thread::yield();
+        Collect();
+    }
+}
+
+size_t Dted_Epoch::Pending() const {
+    boost::mutex::scoped_lock lock(retiredMutex);
+    return retiredObjects.size();
+}
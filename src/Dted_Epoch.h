@@ -0,0 +1,169 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Epoch based reclamation for objects shared between
+//               lock-free readers and a writer that unlinks them.
+//
+//               Readers bracket every access with a Guard.  A writer
+//               first unlinks an object (so that no new reader can
+//               reach it) and then hands it to retire().  The object is
+//               freed only once every reader that was active at the
+//               time of the retire has left its critical section.
+//               Each reader thread owns one of MAX_READERS slots until
+//               it exits.
+//
+//********************************************************************
+
+#ifndef Dted_Epoch_H
+#define Dted_Epoch_H
+
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+using namespace std;
+
+class Dted_Epoch {
+public:
+
+    enum {
+        MAX_READERS = 256,  // Concurrent reader threads per instance
+        COLLECT_THRESHOLD = 64 // Retired objects before a collect
+    };
+
+    //! Deleter invoked on a retired object once it is safe to free.
+    typedef void (*Deleter)(void* object);
+
+    //! RAII reader critical section.
+    class Guard {
+    public:
+        //! @param wait wait for a reader slot (see Enter()) rather than
+        //! leave the guard unentered (see Try_Enter()).
+        Guard(Dted_Epoch& epoch, bool wait = true);
+        ~Guard();
+
+        //! Returns false if no reader slot was free.
+        bool Is_Entered() const;
+    private:
+        Guard(const Guard&);
+        const Guard& operator=(const Guard&);
+
+        Dted_Epoch& theEpoch;
+        bool entered;
+    };
+
+    Dted_Epoch();
+
+    //! Frees every retired object.  No reader may be active.
+    ~Dted_Epoch();
+
+    //! Enter a reader critical section.  May be nested.  The first
+    //! Enter() of a thread without a slot blocks while all MAX_READERS
+    //! slots are owned, until a reader thread exits.
+    void Enter();
+
+    //! Enter a reader critical section without waiting for a slot.
+    //! @return false, not entered, if the thread has no slot and all
+    //! reader slots are taken.
+    bool Try_Enter();
+
+    //! Leave a reader critical section.
+    void Exit();
+
+    //! Register the calling thread as a reader ahead of time so that
+    //! the first Enter() on this thread neither allocates nor blocks.
+    //! Never waits for a slot.
+    //! @return false if all reader slots are taken.
+    bool Register_Thread();
+
+    //! Defer destruction of an already unlinked object.
+    void Retire(void* object, Deleter deleter);
+
+    //! Free every retired object no active reader can still hold.
+    void Collect();
+
+    //! Block until every object retired so far has been freed.
+    void Synchronize();
+
+    //! Number of retired objects still awaiting reclamation.
+    size_t Pending() const;
+
+    //! Convenience deleter for objects allocated with new.
+    template<class T>
+    static void Delete_Object(void* object) {
+        delete static_cast<T*>(object);
+    }
+
+private:
+
+    Dted_Epoch(const Dted_Epoch&);
+    const Dted_Epoch& operator=(const Dted_Epoch&);
+
+    //! A reader slot, padded to its own cache line.
+    struct Reader_Slot {
+        //! Epoch observed on entry, 0 when the reader is quiescent.
+        boost::atomic<unsigned long> epoch;
+        //! True while the slot is owned by a thread.
+        boost::atomic<bool> inUse;
+        //! Nesting depth, only touched by the owning thread.
+        unsigned int depth;
+        char pad[48]; // Pad to a 64 byte cache line.
+    };
+
+    //! Reader slots.  Shared with the thread handles so that a thread
+    //! exiting after the Dted_Epoch is gone still releases safely.
+    struct Reader_Table {
+        Reader_Table();
+        Reader_Slot slots[MAX_READERS];
+
+        //! Signalled as a thread releases its slot.
+        boost::mutex slotMutex;
+        boost::condition_variable slotReleased;
+
+        //! Take a free slot in one pass, NULL if none is free.
+        Reader_Slot* Try_Acquire();
+    };
+
+    //! Thread specific handle on a reader slot, released at thread exit.
+    struct Slot_Handle {
+        boost::shared_ptr<Reader_Table> table;
+        Reader_Slot* slot;
+        ~Slot_Handle();
+    };
+
+    struct Retired_Object {
+        void* object;
+        Deleter deleter;
+        unsigned long epoch;
+    };
+
+    //! Returns the calling thread's slot, taking one if it has none.
+    //! @param wait block until a slot is free rather than return NULL.
+    Reader_Slot* Acquire_Slot(bool wait);
+
+    //! Smallest epoch held by an active reader, ~0 if none.
+    unsigned long Min_Active_Epoch() const;
+
+    //! Global epoch, advanced on every retire.
+    boost::atomic<unsigned long> globalEpoch;
+
+    boost::shared_ptr<Reader_Table> readerTable;
+
+    boost::thread_specific_ptr<Slot_Handle> threadSlot;
+
+    //! Objects awaiting reclamation, guarded by retiredMutex.
+    vector<Retired_Object> retiredObjects;
+    mutable boost::mutex retiredMutex;
+};
+
+#endif
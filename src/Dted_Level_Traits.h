@@ -0,0 +1,60 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Compile time description of each Dted level: posts per
+//               longitude line and post spacing along it, as given by
+//               MIL-PRF-89020B.  The spacing along a parallel widens
+//               towards the poles and is read from each cell.
+//
+//********************************************************************
+
+#ifndef Dted_Level_Traits_H
+#define Dted_Level_Traits_H
+
+#include "Dted_Common.h"
+
+template<Dted_Level L>
+struct Dted_Level_Traits;
+
+template<>
+struct Dted_Level_Traits<LEVEL_0> {
+    enum {
+        LEVEL = LEVEL_0,
+        LAT_POINTS = 121, // Posts per longitude line
+        LAT_SPACING = 300 // Tenths of arc seconds
+    };
+
+    static const char* Name() {
+        return "DTED0";
+    }
+};
+
+template<>
+struct Dted_Level_Traits<LEVEL_1> {
+    enum {
+        LEVEL = LEVEL_1, LAT_POINTS = 1201, LAT_SPACING = 30
+    };
+
+    static const char* Name() {
+        return "DTED1";
+    }
+};
+
+template<>
+struct Dted_Level_Traits<LEVEL_2> {
+    enum {
+        LEVEL = LEVEL_2, LAT_POINTS = 3601, LAT_SPACING = 10
+    };
+
+    static const char* Name() {
+        return "DTED2";
+    }
+};
+
+#endif
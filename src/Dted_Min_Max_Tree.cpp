@@ -0,0 +1,80 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Min/max hierarchy of the posts of a Dted cell.
+//
+//********************************************************************
+
+#include <algorithm>
+
+#include "Dted_Min_Max_Tree.h"
+
+Dted_Min_Max_Tree::Dted_Min_Max_Tree(const short* posts, int numLonLines,
+        int numLatPoints) :
+        numLonLines(numLonLines),
+        numLatPoints(numLatPoints) {
+    Tree_Level leaves;
+    leaves.numX = (numLonLines + LEAF_SIZE - 1) / LEAF_SIZE;
+    leaves.numY = (numLatPoints + LEAF_SIZE - 1) / LEAF_SIZE;
+    leaves.minPosts.assign((size_t) leaves.numX * leaves.numY, 32767);
+    leaves.maxPosts.assign((size_t) leaves.numX * leaves.numY, -32767);
+
+    for (int x = 0; x < numLonLines; x++) {
+        const short* line = posts + (size_t) x * numLatPoints;
+        int row = (x / LEAF_SIZE) * leaves.numY;
+
+        for (int y = 0; y < numLatPoints; y++) {
+            if (line[y] == NULL_POST)
+                continue;
+
+            int block = row + y / LEAF_SIZE;
+
+            if (line[y] < leaves.minPosts[block])
+                leaves.minPosts[block] = line[y];
+
+            if (line[y] > leaves.maxPosts[block])
+                leaves.maxPosts[block] = line[y];
+        }
+    }
+
+    levels.push_back(leaves);
+
+    while ((levels.back().numX > 1) || (levels.back().numY > 1)) {
+        const Tree_Level& below = levels.back();
+        Tree_Level above;
+        above.numX = (below.numX + 1) / 2;
+        above.numY = (below.numY + 1) / 2;
+        above.minPosts.assign((size_t) above.numX * above.numY, 32767);
+        above.maxPosts.assign((size_t) above.numX * above.numY, -32767);
+
+        for (int x = 0; x < below.numX; x++) {
+            for (int y = 0; y < below.numY; y++) {
+                int child = x * below.numY + y;
+                int block = (x / 2) * above.numY + y / 2;
+
+                above.minPosts[block] = min(above.minPosts[block],
+                        below.minPosts[child]);
+                above.maxPosts[block] = max(above.maxPosts[block],
+                        below.maxPosts[child]);
+            }
+        }
+
+        levels.push_back(above);
+    }
+}
+
+size_t Dted_Min_Max_Tree::Get_Size() const {
+    size_t size = 0;
+
+    for (size_t l = 0; l < levels.size(); l++)
+        size += (levels[l].minPosts.size() + levels[l].maxPosts.size())
+                * sizeof(short);
+
+    return size;
+}
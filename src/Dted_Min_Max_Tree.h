@@ -0,0 +1,165 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Min/max hierarchy of the posts of a Dted cell.  The
+//               leaves hold the lowest and highest post of each
+//               LEAF_SIZE x LEAF_SIZE block of posts and every level
+//               above merges 2 x 2 blocks of the level below, up to a
+//               single block covering the cell.  A region query descends
+//               only into the blocks overlapping the region whose bound
+//               can still beat the best post found, and only reads posts
+//               in leaves crossing the region's edge.
+//
+//********************************************************************
+
+#ifndef Dted_Min_Max_Tree_H
+#define Dted_Min_Max_Tree_H
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Dted_Common.h"
+
+using namespace std;
+
+class Dted_Min_Max_Tree {
+public:
+
+    enum {
+        LEAF_SIZE = 16 // Posts per leaf block side
+    };
+
+    //! Range of post indexes, bounds included.
+    typedef struct {
+        int x0;
+        int x1;
+        int y0;
+        int y1;
+    } Post_Range;
+
+    /*! Build the hierarchy of posts laid out one longitude line after the
+     other.
+     @param posts numLonLines * numLatPoints posts.
+     */
+    Dted_Min_Max_Tree(const short* posts, int numLonLines, int numLatPoints);
+
+    /*! Find the highest (or lowest) non void post in a range.
+     @param posts accessor of the cell's posts, posts(x, y0, y1, line)
+     filling line with posts y0 to y1 of longitude line x; called only
+     for leaves crossing the range's edge, once per line.
+     @param range posts to search, within the cell.
+     @param findMax search the highest post rather than the lowest.
+     @param best set to the post found.
+     @return false if every post of the range is void.
+     */
+    template<class Posts>
+    bool Find(const Posts& posts, const Post_Range& range, bool findMax,
+            short& best) const {
+        bool found = false;
+        int top = levels.size() - 1;
+
+        for (int bx = 0; bx < levels[top].numX; bx++)
+            for (int by = 0; by < levels[top].numY; by++)
+                Find_Block(posts, range, findMax, top, bx, by, best, found);
+
+        return found;
+    }
+
+    //! Bytes held by the hierarchy.
+    size_t Get_Size() const;
+
+private:
+
+    Dted_Min_Max_Tree(const Dted_Min_Max_Tree&);
+    const Dted_Min_Max_Tree& operator=(const Dted_Min_Max_Tree&);
+
+    struct Tree_Level {
+        int numX;
+        int numY;
+        //! Per block, 32767 and -32767 if all its posts are void.
+        vector<short> minPosts;
+        vector<short> maxPosts;
+    };
+
+    template<class Posts>
+    void Find_Block(const Posts& posts, const Post_Range& range,
+            bool findMax, int level, int bx, int by, short& best,
+            bool& found) const {
+        const Tree_Level& treeLevel = levels[level];
+        int block = bx * treeLevel.numY + by;
+        int size = LEAF_SIZE << level;
+        int x0 = bx * size;
+        int y0 = by * size;
+        int x1 = min(x0 + size - 1, numLonLines - 1);
+        int y1 = min(y0 + size - 1, numLatPoints - 1);
+
+        if ((x0 > range.x1) || (x1 < range.x0) || (y0 > range.y1)
+                || (y1 < range.y0))
+            return;
+
+        // Void block.
+        if (treeLevel.minPosts[block] > treeLevel.maxPosts[block])
+            return;
+
+        short bound =
+                findMax ? treeLevel.maxPosts[block] :
+                        treeLevel.minPosts[block];
+
+        // None of its posts can beat the best.
+        if (found && (findMax ? (bound <= best) : (bound >= best)))
+            return;
+
+        if ((x0 >= range.x0) && (x1 <= range.x1) && (y0 >= range.y0)
+                && (y1 <= range.y1)) {
+            best = bound;
+            found = true;
+            return;
+        }
+
+        if (level == 0) {
+            int ly0 = max(y0, range.y0);
+            int ly1 = min(y1, range.y1);
+            short line[LEAF_SIZE];
+
+            for (int x = max(x0, range.x0); x <= min(x1, range.x1); x++) {
+                posts(x, ly0, ly1, line);
+
+                for (int y = 0; y <= ly1 - ly0; y++) {
+                    short post = line[y];
+
+                    if ((post != NULL_POST)
+                            && (!found
+                                    || (findMax ? (post > best) : (post < best)))) {
+                        best = post;
+                        found = true;
+                    }
+                }
+            }
+
+            return;
+        }
+
+        for (int cx = 2 * bx; cx <= min(2 * bx + 1, levels[level - 1].numX - 1);
+                cx++)
+            for (int cy = 2 * by;
+                    cy <= min(2 * by + 1, levels[level - 1].numY - 1); cy++)
+                Find_Block(posts, range, findMax, level - 1, cx, cy, best,
+                        found);
+    }
+
+    int numLonLines;
+    int numLatPoints;
+
+    //! levels[0] holds the leaves.
+    vector<Tree_Level> levels;
+};
+
+#endif
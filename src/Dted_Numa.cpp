@@ -0,0 +1,131 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  NUMA topology and placement helpers.
+//
+//********************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "Dted_Numa.h"
+
+using namespace std;
+
+namespace {
+
+enum {
+    MPOL_BIND_POLICY = 2, // MPOL_BIND of <numaif.h>
+    MAX_NODES = 64
+};
+
+//! Parse a sysfs list such as "0-3,8-11", calling back for each entry.
+template<class Visitor>
+bool Parse_List(const string& path, Visitor visit) {
+    ifstream listStr(path.c_str());
+    string list;
+
+    if (!listStr.is_open() || !getline(listStr, list))
+        return false;
+
+    istringstream rangesStr(list);
+    string range;
+
+    while (getline(rangesStr, range, ',')) {
+        int first;
+        int last;
+
+        if (sscanf(range.c_str(), "%d-%d", &first, &last) != 2) {
+            if (sscanf(range.c_str(), "%d", &first) != 1)
+                continue;
+
+            last = first;
+        }
+
+        for (int i = first; i <= last; i++)
+            visit(i);
+    }
+
+    return true;
+}
+
+struct Max_Visitor {
+    int* maximum;
+
+    void operator()(int i) {
+        if (i > *maximum)
+            *maximum = i;
+    }
+};
+
+struct Cpu_Visitor {
+    cpu_set_t* cpus;
+
+    void operator()(int i) {
+        if (i < CPU_SETSIZE)
+            CPU_SET(i, cpus);
+    }
+};
+
+}
+
+int Dted_Numa::Get_Node_Count() {
+    static int nodeCount = 0;
+
+    if (nodeCount == 0) {
+        int maximum = 0;
+        Max_Visitor visitor = { &maximum };
+
+        Parse_List("/sys/devices/system/node/online", visitor);
+
+        nodeCount = (maximum < MAX_NODES) ? maximum + 1 : MAX_NODES;
+    }
+
+    return nodeCount;
+}
+
+bool Dted_Numa::Get_Node_Cpus(int node, cpu_set_t& cpus) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+            node);
+
+    CPU_ZERO(&cpus);
+    Cpu_Visitor visitor = { &cpus };
+
+    return Parse_List(path, visitor) && (CPU_COUNT(&cpus) > 0);
+}
+
+bool Dted_Numa::Bind_Memory(void* address, size_t length, int node) {
+    if ((node < 0) || (node >= MAX_NODES))
+        return false;
+
+#ifdef SYS_mbind
+    unsigned long nodeMask = 1UL << node;
+
+    return syscall(SYS_mbind, address, length, MPOL_BIND_POLICY, &nodeMask,
+            sizeof(nodeMask) * 8, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+bool Dted_Numa::Pin_Thread(int node) {
+    cpu_set_t cpus;
+
+    if (!Get_Node_Cpus(node, cpus))
+        return false;
+
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
@@ -0,0 +1,42 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  NUMA topology and placement helpers.  The topology is
+//               read from sysfs and memory is bound with the mbind
+//               system call, so no NUMA library is needed; on systems
+//               without NUMA every helper behaves as for a single node.
+//
+//********************************************************************
+
+#ifndef Dted_Numa_H
+#define Dted_Numa_H
+
+#include <sched.h>
+#include <stddef.h>
+
+class Dted_Numa {
+public:
+
+    //! Number of NUMA nodes, 1 without NUMA support.
+    static int Get_Node_Count();
+
+    //! CPUs of a node.
+    //! @return Returns true on success, false if unknown.
+    static bool Get_Node_Cpus(int node, cpu_set_t& cpus);
+
+    //! Bind a page aligned range of memory not yet touched to a node.
+    //! @return Returns true on success, false on error.
+    static bool Bind_Memory(void* address, size_t length, int node);
+
+    //! Run the calling thread on the CPUs of a node.
+    //! @return Returns true on success, false on error.
+    static bool Pin_Thread(int node);
+};
+
+#endif
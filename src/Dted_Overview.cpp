@@ -0,0 +1,135 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Reduced resolution overviews of a Dted cell.
+//
+//********************************************************************
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "Dted_Overview.h"
+
+Dted_Overview::Dted_Overview(const short* posts, int numLonLines,
+        int numLatPoints, int levelCount, unsigned int modes) :
+        modes(modes) {
+    levelCount = min(levelCount, (int) MAX_LEVELS);
+
+    for (int level = 1; level <= levelCount; level++) {
+        int factor = 1 << level;
+
+        // Nothing left to reduce.
+        if ((factor >= numLonLines) && (factor >= numLatPoints))
+            break;
+
+        levels.push_back(Overview_Level());
+        Build_Level(posts, numLonLines, numLatPoints, factor, levels.back());
+    }
+}
+
+void Dted_Overview::Build_Level(const short* posts, int numLonLines,
+        int numLatPoints, int factor, Overview_Level& overviewLevel) {
+    overviewLevel.numLonLines = (numLonLines + factor - 2) / factor + 1;
+    overviewLevel.numLatPoints = (numLatPoints + factor - 2) / factor + 1;
+
+    size_t numPosts = (size_t) overviewLevel.numLonLines
+            * overviewLevel.numLatPoints;
+
+    for (int m = 0; m < NUM_MODES; m++)
+        if (modes & (1 << m))
+            overviewLevel.posts[m].resize(numPosts);
+
+    bool summarize = (modes & (OVERVIEW_AVERAGE | OVERVIEW_MIN | OVERVIEW_MAX))
+            != 0;
+
+    for (int x = 0; x < overviewLevel.numLonLines; x++) {
+        int sx = min(x * factor, numLonLines - 1);
+
+        for (int y = 0; y < overviewLevel.numLatPoints; y++) {
+            int sy = min(y * factor, numLatPoints - 1);
+            size_t post = (size_t) x * overviewLevel.numLatPoints + y;
+
+            if (modes & OVERVIEW_DECIMATE)
+                overviewLevel.posts[Mode_Index(OVERVIEW_DECIMATE)][post] =
+                        posts[(size_t) sx * numLatPoints + sy];
+
+            if (!summarize)
+                continue;
+
+            int x0 = max(sx - factor / 2, 0);
+            int x1 = min(sx + factor / 2, numLonLines - 1);
+            int y0 = max(sy - factor / 2, 0);
+            int y1 = min(sy + factor / 2, numLatPoints - 1);
+
+            long sum = 0;
+            int count = 0;
+            short minPost = 32767;
+            short maxPost = -32767;
+
+            for (int i = x0; i <= x1; i++) {
+                const short* line = posts + (size_t) i * numLatPoints;
+
+                for (int j = y0; j <= y1; j++) {
+                    if (line[j] == NULL_POST)
+                        continue;
+
+                    sum += line[j];
+                    count++;
+
+                    if (line[j] < minPost)
+                        minPost = line[j];
+
+                    if (line[j] > maxPost)
+                        maxPost = line[j];
+                }
+            }
+
+            if (count == 0)
+                minPost = maxPost = NULL_POST;
+
+            if (modes & OVERVIEW_AVERAGE)
+                overviewLevel.posts[Mode_Index(OVERVIEW_AVERAGE)][post] =
+                        (count == 0) ? (short) NULL_POST :
+                                (short) floor((double) sum / count + 0.5);
+
+            if (modes & OVERVIEW_MIN)
+                overviewLevel.posts[Mode_Index(OVERVIEW_MIN)][post] = minPost;
+
+            if (modes & OVERVIEW_MAX)
+                overviewLevel.posts[Mode_Index(OVERVIEW_MAX)][post] = maxPost;
+        }
+    }
+}
+
+int Dted_Overview::Get_Level_Count() const {
+    return levels.size();
+}
+
+bool Dted_Overview::Has_Mode(Overview_Mode mode) const {
+    return (modes & mode) != 0;
+}
+
+int Dted_Overview::Get_Lon_Lines(int level) const {
+    return levels[level - 1].numLonLines;
+}
+
+int Dted_Overview::Get_Lat_Points(int level) const {
+    return levels[level - 1].numLatPoints;
+}
+
+size_t Dted_Overview::Get_Size() const {
+    size_t size = 0;
+
+    for (size_t l = 0; l < levels.size(); l++)
+        for (int m = 0; m < NUM_MODES; m++)
+            size += levels[l].posts[m].size() * sizeof(short);
+
+    return size;
+}
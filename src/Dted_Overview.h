@@ -0,0 +1,97 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Reduced resolution overviews of the posts of a Dted
+//               cell.  Overview level k keeps every 2^k-th post along
+//               both axes, the last line and point of the cell
+//               included.  Besides the decimated posts, an overview post
+//               may hold the mean, minimum or maximum of the cell's
+//               posts within half an overview spacing of it, void posts
+//               excluded.
+//
+//********************************************************************
+
+#ifndef Dted_Overview_H
+#define Dted_Overview_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "Dted_Common.h"
+
+using namespace std;
+
+class Dted_Overview {
+public:
+
+    enum {
+        MAX_LEVELS = 8, NUM_MODES = 4
+    };
+
+    /*! Build the overviews of posts laid out one longitude line after
+     the other.
+     @param posts numLonLines * numLatPoints posts.
+     @param levels number of overview levels, at most MAX_LEVELS; level k
+     (from 1) holds every 2^k-th post.
+     @param modes Overview_Mode values or'ed together.
+     */
+    Dted_Overview(const short* posts, int numLonLines, int numLatPoints,
+            int levels, unsigned int modes);
+
+    //! Number of overview levels.
+    int Get_Level_Count() const;
+
+    //! Returns true if the overviews hold the posts of a mode.
+    bool Has_Mode(Overview_Mode mode) const;
+
+    //! Longitude lines of an overview level.
+    int Get_Lon_Lines(int level) const;
+
+    //! Latitude points of an overview level.
+    int Get_Lat_Points(int level) const;
+
+    //! Return post (x, y) of an overview level and mode, which must have
+    //! been built.
+    inline short Get_Post(int level, Overview_Mode mode, int x,
+            int y) const {
+        const Overview_Level& overviewLevel = levels[level - 1];
+
+        return overviewLevel.posts[Mode_Index(mode)][x
+                * overviewLevel.numLatPoints + y];
+    }
+
+    //! Bytes held by the overviews.
+    size_t Get_Size() const;
+
+private:
+
+    Dted_Overview(const Dted_Overview&);
+    const Dted_Overview& operator=(const Dted_Overview&);
+
+    struct Overview_Level {
+        int numLonLines;
+        int numLatPoints;
+        vector<short> posts[NUM_MODES];
+    };
+
+    static inline int Mode_Index(Overview_Mode mode) {
+        return (mode == OVERVIEW_DECIMATE) ? 0 :
+                (mode == OVERVIEW_AVERAGE) ? 1 :
+                (mode == OVERVIEW_MIN) ? 2 : 3;
+    }
+
+    void Build_Level(const short* posts, int numLonLines, int numLatPoints,
+            int factor, Overview_Level& overviewLevel);
+
+    unsigned int modes;
+    vector<Overview_Level> levels;
+};
+
+#endif
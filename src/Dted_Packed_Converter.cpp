@@ -0,0 +1,144 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Converts Dted cells into packed cells.
+//
+//********************************************************************
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <iostream>
+
+#include "Dted_Cell.h"
+#include "Dted_Packed_Converter.h"
+
+Dted_Packed_Converter::Dted_Packed_Converter() :
+        converted(0),
+        skipped(0),
+        verbose(false) {
+}
+
+bool Dted_Packed_Converter::Convert_Cell(const string& dtedFile,
+        const string& packedFile) {
+    Dted_Cell dtedCell(dtedFile);
+
+    if (dtedCell.isPacked() || (dtedCell.getDataRegionSize() == 0))
+        return false;
+
+    return dtedCell.writePacked(packedFile);
+}
+
+int Dted_Packed_Converter::Convert_Tree(const string& dtedPath,
+        const string& packedPath) {
+    converted = 0;
+    skipped = 0;
+
+    // Create the parents of the packed tree; Convert_Directory() creates
+    // the rest.
+    for (size_t slash = packedPath.find('/', 1); slash != string::npos;
+            slash = packedPath.find('/', slash + 1))
+        mkdir(packedPath.substr(0, slash).c_str(), 0755);
+
+    return Convert_Directory(dtedPath, packedPath);
+}
+
+int Dted_Packed_Converter::Get_Converted() const {
+    return converted;
+}
+
+int Dted_Packed_Converter::Get_Skipped() const {
+    return skipped;
+}
+
+void Dted_Packed_Converter::Set_Verbose(bool newVerbose) {
+    verbose = newVerbose;
+}
+
+bool Dted_Packed_Converter::Is_Dted_File(const string& fileName) {
+    size_t dot = fileName.find_last_of('.');
+
+    if ((dot == string::npos) || (fileName.length() != dot + 4))
+        return false;
+
+    return (tolower(fileName[dot + 1]) == 'd')
+            && (tolower(fileName[dot + 2]) == 't')
+            && (fileName[dot + 3] >= '0') && (fileName[dot + 3] <= '2');
+}
+
+int Dted_Packed_Converter::Convert_Directory(const string& dtedPath,
+        const string& packedPath) {
+    DIR* directory = opendir(dtedPath.c_str());
+
+    if (directory == NULL) {
+        cerr << "ERROR: Can not open directory: '" << dtedPath << "'" << endl;
+        return 1;
+    }
+
+    if ((mkdir(packedPath.c_str(), 0755) != 0) && (errno != EEXIST)) {
+        cerr << "ERROR: Can not create directory: '" << packedPath << "'"
+                << endl;
+        closedir(directory);
+        return 1;
+    }
+
+    int failed = 0;
+    struct dirent* entry;
+
+    while ((entry = readdir(directory)) != NULL) {
+        if ((strcmp(entry->d_name, ".") == 0)
+                || (strcmp(entry->d_name, "..") == 0))
+            continue;
+
+        string name(entry->d_name);
+        string source = dtedPath + "/" + name;
+
+        struct stat sourceStat;
+
+        if (stat(source.c_str(), &sourceStat) != 0)
+            continue;
+
+        if (S_ISDIR(sourceStat.st_mode)) {
+            failed += Convert_Directory(source, packedPath + "/" + name);
+            continue;
+        }
+
+        if (!Is_Dted_File(name))
+            continue;
+
+        string target = packedPath + "/" + name.substr(0, name.rfind('.'))
+                + ".dtp";
+
+        struct stat targetStat;
+
+        if ((stat(target.c_str(), &targetStat) == 0)
+                && (targetStat.st_mtime >= sourceStat.st_mtime)) {
+            skipped++;
+            continue;
+        }
+
+        if (Convert_Cell(source, target)) {
+            converted++;
+
+            if (verbose)
+                cout << source << " -> " << target << endl;
+        } else {
+            failed++;
+            cerr << "ERROR: Can not convert: '" << source << "'" << endl;
+        }
+    }
+
+    closedir(directory);
+
+    return failed;
+}
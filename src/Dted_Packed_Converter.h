@@ -0,0 +1,61 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Converts Dted cells into packed cells (".dtp").  A tree
+//               is converted into a tree of the same layout (meridian
+//               directories holding one file per parallel) which a
+//               Dted_Database can populate like a Dted tree.
+//
+//********************************************************************
+
+#ifndef Dted_Packed_Converter_H
+#define Dted_Packed_Converter_H
+
+#include <string>
+
+using namespace std;
+
+class Dted_Packed_Converter {
+public:
+
+    Dted_Packed_Converter();
+
+    //! Convert a single Dted file.
+    //! @return Returns true on success, false on error.
+    bool Convert_Cell(const string& dtedFile, const string& packedFile);
+
+    /*! Convert every Dted file below dtedPath into packedPath, creating
+     directories as needed.  Packed cells newer than their Dted file are
+     kept.
+     @return number of cells that failed to convert.
+     */
+    int Convert_Tree(const string& dtedPath, const string& packedPath);
+
+    //! Number of cells converted by the last Convert_Tree().
+    int Get_Converted() const;
+
+    //! Number of up to date cells skipped by the last Convert_Tree().
+    int Get_Skipped() const;
+
+    //! Report progress on standard output.
+    void Set_Verbose(bool verbose);
+
+private:
+
+    //! Returns true if a filename has a Dted extension.
+    static bool Is_Dted_File(const string& fileName);
+
+    int Convert_Directory(const string& dtedPath, const string& packedPath);
+
+    int converted;
+    int skipped;
+    bool verbose;
+};
+
+#endif
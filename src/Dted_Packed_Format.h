@@ -0,0 +1,70 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Layout of a packed Dted cell (".dtp").  A packed cell
+//               holds the posts of one Dted cell as native-endian
+//               shorts, one longitude line (south to north) after the
+//               other, behind a fixed header padded to a page.  The
+//               posts can therefore be memory mapped and used without
+//               any decoding.  Packed cells are produced by
+//               Dted_Packed_Converter and are only valid on machines of
+//               the byte order that wrote them.  A cell whose posts all
+//               have one value is written as its header alone.
+//
+//********************************************************************
+
+#ifndef Dted_Packed_Format_H
+#define Dted_Packed_Format_H
+
+#include <string.h>
+
+struct Dted_Packed_Header {
+    enum {
+        VERSION = 1,
+        BYTE_ORDER_MARK = 0x01020304,
+        PAGE_SIZE = 4096, // Posts start on this boundary
+        TEXT_SIZE = 16,
+        UNIFORM = 0x1 // Flag: no posts, every post is uniformValue
+    };
+
+    //! "DTEDPACK"
+    char magic[8];
+    unsigned int version;
+    //! BYTE_ORDER_MARK in the byte order of the writer.
+    unsigned int byteOrder;
+
+    int numLonLines;
+    int numLatPoints;
+    double latSpacing;
+    double lonSpacing;
+    double swCornerLat;
+    double swCornerLon;
+
+    //! Statistics gathered by the converter.
+    float minHeightAboveMSL;
+    float maxHeightAboveMSL;
+
+    //! Offset and size in bytes of the posts.
+    unsigned long long postsOffset;
+    unsigned long long postsSize;
+
+    char edition[TEXT_SIZE];
+    char productLevel[TEXT_SIZE];
+    char compilationDate[TEXT_SIZE];
+
+    unsigned int flags;
+    short uniformValue;
+
+    //! Returns true if buffer starts with the packed cell magic.
+    static bool Has_Magic(const char* buffer) {
+        return memcmp(buffer, "DTEDPACK", 8) == 0;
+    }
+};
+
+#endif
@@ -0,0 +1,141 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Cache of decoded pages of Dted cells.
+//
+//********************************************************************
+
+#include <stdlib.h>
+
+#include "Dted_Cell.h"
+#include "Dted_Page_Cache.h"
+
+Dted_Page_Cache::Dted_Page_Cache(Dted_Epoch& epoch, size_t capacity) :
+        pageEpoch(epoch),
+        clockHand(0),
+        cacheSize(0),
+        cacheCapacity(capacity) {
+}
+
+Dted_Page_Cache::~Dted_Page_Cache() {
+    for (size_t i = 0; i < cachedPages.size(); i++)
+        free(cachedPages[i].slot->posts.exchange(NULL));
+}
+
+void Dted_Page_Cache::Set_Capacity(size_t capacity) {
+    vector<short*> evictedPosts;
+
+    {
+        boost::mutex::scoped_lock lock(cacheMutex);
+
+        cacheCapacity = capacity;
+        Evict(evictedPosts);
+    }
+
+    Retire_Pages(evictedPosts);
+}
+
+size_t Dted_Page_Cache::Get_Size() const {
+    boost::mutex::scoped_lock lock(cacheMutex);
+    return cacheSize;
+}
+
+const short* Dted_Page_Cache::Load_Page(Dted_Cell* dtedCellPtr, int page) {
+    Page_Slot* slot = dtedCellPtr->pageSlot(page);
+    size_t size = 0;
+
+    // Read outside the lock so that pages of other cells load meanwhile.
+    short* posts = dtedCellPtr->readPage(page, size);
+
+    if (posts == NULL)
+        return NULL;
+
+    vector<short*> evictedPosts;
+
+    {
+        boost::mutex::scoped_lock lock(cacheMutex);
+
+        short* cachedPosts = NULL;
+
+        if (!slot->posts.compare_exchange_strong(cachedPosts, posts)) {
+            // Another query loaded it first.
+            free(posts);
+            return cachedPosts;
+        }
+
+        slot->referenced.store(true, boost::memory_order_relaxed);
+
+        Cached_Page cachedPage;
+        cachedPage.cell = dtedCellPtr;
+        cachedPage.slot = slot;
+        cachedPage.size = size;
+
+        cachedPages.push_back(cachedPage);
+        cacheSize += size;
+
+        Evict(evictedPosts);
+    }
+
+    // The caller holds the epoch, so the page stays valid even if just
+    // evicted.
+    Retire_Pages(evictedPosts);
+
+    return posts;
+}
+
+void Dted_Page_Cache::Release_Cell(Dted_Cell* dtedCellPtr) {
+    boost::mutex::scoped_lock lock(cacheMutex);
+
+    size_t i = 0;
+
+    while (i < cachedPages.size()) {
+        if (cachedPages[i].cell != dtedCellPtr) {
+            i++;
+            continue;
+        }
+
+        // The cell is retired, so no query can be reading its pages.
+        free(cachedPages[i].slot->posts.exchange(NULL));
+        cacheSize -= cachedPages[i].size;
+
+        cachedPages[i] = cachedPages.back();
+        cachedPages.pop_back();
+    }
+}
+
+void Dted_Page_Cache::Evict(vector<short*>& evictedPosts) {
+    while ((cacheSize > cacheCapacity) && !cachedPages.empty()) {
+        if (clockHand >= cachedPages.size())
+            clockHand = 0;
+
+        Cached_Page& cachedPage = cachedPages[clockHand];
+
+        // Give recently read pages another turn of the clock.
+        if (cachedPage.slot->referenced.exchange(false,
+                boost::memory_order_relaxed)) {
+            clockHand++;
+            continue;
+        }
+
+        evictedPosts.push_back(cachedPage.slot->posts.exchange(NULL));
+        cacheSize -= cachedPage.size;
+
+        cachedPage = cachedPages.back();
+        cachedPages.pop_back();
+    }
+}
+
+void Dted_Page_Cache::Retire_Pages(const vector<short*>& evictedPosts) {
+    for (size_t i = 0; i < evictedPosts.size(); i++)
+        pageEpoch.Retire(evictedPosts[i], Free_Page);
+}
+
+void Dted_Page_Cache::Free_Page(void* posts) {
+    free(posts);
+}
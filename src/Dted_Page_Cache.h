@@ -0,0 +1,110 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Cache of decoded pages of Dted cells shared by the cells
+//               of a database (PAGED_ACCESS).  A page holds PAGE_LINES
+//               longitude lines of a cell, so a query pulls in only the
+//               columns it touches.  Each cell keeps a lock-free table of
+//               its cached pages; the cache evicts pages with the clock
+//               algorithm once it exceeds its capacity, and frees them
+//               through the epoch guarding the queries.
+//
+//********************************************************************
+
+#ifndef Dted_Page_Cache_H
+#define Dted_Page_Cache_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "Dted_Epoch.h"
+
+using namespace std;
+
+class Dted_Cell;
+
+class Dted_Page_Cache {
+public:
+
+    enum {
+        PAGE_LINES = 64 // Longitude lines per page
+    };
+
+    //! Entry of a cell's page table.
+    struct Page_Slot {
+        Page_Slot() :
+                posts(NULL),
+                referenced(false) {
+        }
+
+        //! Decoded posts of the page, NULL unless cached.
+        boost::atomic<short*> posts;
+        //! Set by queries, cleared by the clock hand.
+        boost::atomic<bool> referenced;
+    };
+
+    /*! @param epoch epoch that the readers of the pages hold.
+     @param capacity bytes of decoded posts to keep.
+     */
+    Dted_Page_Cache(Dted_Epoch& epoch, size_t capacity);
+
+    //! Frees the cached pages.  Their cells must be gone.
+    ~Dted_Page_Cache();
+
+    //! Set the bytes of decoded posts to keep, evicting if needed.
+    void Set_Capacity(size_t capacity);
+
+    //! Bytes of decoded posts cached.
+    size_t Get_Size() const;
+
+    /*! Read a page of a cell into the cache.  The page stays valid while
+     the caller holds the epoch.
+     @return the decoded posts, or NULL if the page can not be read.
+     */
+    const short* Load_Page(Dted_Cell* dtedCellPtr, int page);
+
+    //! Free the cached pages of a cell which is being destroyed.
+    void Release_Cell(Dted_Cell* dtedCellPtr);
+
+private:
+
+    Dted_Page_Cache(const Dted_Page_Cache&);
+    const Dted_Page_Cache& operator=(const Dted_Page_Cache&);
+
+    struct Cached_Page {
+        Dted_Cell* cell;
+        Page_Slot* slot;
+        size_t size;
+    };
+
+    //! Evict pages until the cache fits.  Called under cacheMutex.
+    //! @param evictedPosts receives the posts of the evicted pages.
+    void Evict(vector<short*>& evictedPosts);
+
+    //! Hand evicted posts to the epoch.  Must not be called under
+    //! cacheMutex: retiring may destroy a paged cell, which releases its
+    //! pages through Release_Cell().
+    void Retire_Pages(const vector<short*>& evictedPosts);
+
+    static void Free_Page(void* posts);
+
+    Dted_Epoch& pageEpoch;
+
+    mutable boost::mutex cacheMutex;
+    vector<Cached_Page> cachedPages;
+    size_t clockHand;
+    size_t cacheSize;
+    size_t cacheCapacity;
+};
+
+#endif
@@ -0,0 +1,139 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Runs bulk queries on NUMA node local worker threads.
+//
+//********************************************************************
+
+#include <boost/bind/bind.hpp>
+
+#include "Dted_Numa.h"
+#include "Dted_Query_Router.h"
+
+Dted_Query_Router::Dted_Query_Router() :
+        currentQuery(NULL),
+        generation(0),
+        busyWorkers(0),
+        stopping(false),
+        workerCount(0),
+        threadsStarted(false) {
+    int nodeCount = Dted_Numa::Get_Node_Count();
+
+    threadsPerNode = boost::thread::hardware_concurrency() / nodeCount;
+
+    if (threadsPerNode < 1)
+        threadsPerNode = 1;
+
+    for (int node = 0; node < nodeCount; node++) {
+        boost::shared_ptr<Node_Task> nodeTask(new Node_Task());
+        nodeTask->items = NULL;
+        nodeTask->next = 0;
+        nodeTasks.push_back(nodeTask);
+    }
+}
+
+Dted_Query_Router::~Dted_Query_Router() {
+    {
+        boost::mutex::scoped_lock lock(routerMutex);
+        stopping = true;
+    }
+
+    taskReady.notify_all();
+    threads.join_all();
+}
+
+void Dted_Query_Router::Set_Threads_Per_Node(int newThreadsPerNode) {
+    boost::mutex::scoped_lock lock(routerMutex);
+    threadsPerNode = (newThreadsPerNode < 1) ? 1 : newThreadsPerNode;
+}
+
+void Dted_Query_Router::Start_Threads() {
+    if (threadsStarted)
+        return;
+
+    for (size_t node = 0; node < nodeTasks.size(); node++) {
+        for (int i = 0; i < threadsPerNode; i++)
+            threads.create_thread(
+                    boost::bind(&Dted_Query_Router::Worker, this, (int) node));
+    }
+
+    workerCount = nodeTasks.size() * threadsPerNode;
+    threadsStarted = true;
+}
+
+void Dted_Query_Router::Run(const vector<vector<size_t> >& nodeItems,
+        const Query_Function& query) {
+    boost::mutex::scoped_lock runLock(runMutex);
+    boost::mutex::scoped_lock lock(routerMutex);
+
+    Start_Threads();
+
+    for (size_t node = 0; node < nodeTasks.size(); node++) {
+        nodeTasks[node]->items = (node < nodeItems.size()) ?
+                &nodeItems[node] : NULL;
+        nodeTasks[node]->next = 0;
+    }
+
+    currentQuery = &query;
+    busyWorkers = workerCount;
+    generation++;
+
+    taskReady.notify_all();
+
+    while (busyWorkers > 0)
+        taskDone.wait(lock);
+
+    currentQuery = NULL;
+}
+
+void Dted_Query_Router::Worker(int node) {
+    // Without NUMA the pinning fails harmlessly.
+    Dted_Numa::Pin_Thread(node);
+
+    unsigned long seenGeneration = 0;
+
+    boost::mutex::scoped_lock lock(routerMutex);
+
+    while (true) {
+        while (!stopping && (generation == seenGeneration))
+            taskReady.wait(lock);
+
+        if (stopping)
+            return;
+
+        seenGeneration = generation;
+
+        Node_Task& nodeTask = *nodeTasks[node];
+        const Query_Function& query = *currentQuery;
+
+        lock.unlock();
+
+        if (nodeTask.items != NULL) {
+            size_t itemCount = nodeTask.items->size();
+
+            while (true) {
+                size_t first = nodeTask.next.fetch_add(CHUNK_SIZE);
+
+                if (first >= itemCount)
+                    break;
+
+                size_t last = (first + CHUNK_SIZE < itemCount) ?
+                        first + CHUNK_SIZE : itemCount;
+
+                for (size_t i = first; i < last; i++)
+                    query((*nodeTask.items)[i]);
+            }
+        }
+
+        lock.lock();
+
+        if (--busyWorkers == 0)
+            taskDone.notify_all();
+    }
+}
@@ -0,0 +1,99 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Runs bulk queries on worker threads pinned to the NUMA
+//               node owning the cells queried.  The caller splits the
+//               work into one list of items per node; the workers of a
+//               node claim items of their list in chunks, so the posts
+//               they read are in local memory.
+//
+//********************************************************************
+
+#ifndef Dted_Query_Router_H
+#define Dted_Query_Router_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace std;
+
+class Dted_Query_Router {
+public:
+
+    enum {
+        CHUNK_SIZE = 64 // Items claimed at a time by a worker
+    };
+
+    //! Called once per item, concurrently on several threads.
+    typedef boost::function<void(size_t item)> Query_Function;
+
+    Dted_Query_Router();
+
+    //! Stops the workers.
+    ~Dted_Query_Router();
+
+    //! Set the number of workers per node.  Applies when the workers
+    //! are started by the first Run().
+    void Set_Threads_Per_Node(int threadsPerNode);
+
+    /*! Run query on every item and wait for all of them.  One Run()
+     executes at a time.
+     @param nodeItems items to run on the workers of each node, one list
+     per node of Dted_Numa::Get_Node_Count(); missing lists are empty.
+     @param query work of an item.
+     */
+    void Run(const vector<vector<size_t> >& nodeItems,
+            const Query_Function& query);
+
+private:
+
+    Dted_Query_Router(const Dted_Query_Router&);
+    const Dted_Query_Router& operator=(const Dted_Query_Router&);
+
+    //! Work of one node during a Run().
+    struct Node_Task {
+        const vector<size_t>* items;
+        boost::atomic<size_t> next;
+    };
+
+    //! Called with routerMutex held.
+    void Start_Threads();
+
+    void Worker(int node);
+
+    //! Serializes Run().
+    boost::mutex runMutex;
+
+    boost::mutex routerMutex;
+    boost::condition_variable taskReady;
+    boost::condition_variable taskDone;
+
+    vector<boost::shared_ptr<Node_Task> > nodeTasks;
+    const Query_Function* currentQuery;
+
+    //! Bumped by every Run() to wake the workers.
+    unsigned long generation;
+    int busyWorkers;
+    bool stopping;
+
+    int threadsPerNode;
+    int workerCount;
+    bool threadsStarted;
+    boost::thread_group threads;
+};
+
+#endif
@@ -0,0 +1,156 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Cache of decoded Dted cells shared by the processes of a
+//               node.
+//
+//********************************************************************
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include <fstream>
+#include <iostream>
+
+#include "Dted_Cell.h"
+#include "Dted_Packed_Format.h"
+#include "Dted_Shared_Cache.h"
+
+Dted_Shared_Cache::Dted_Shared_Cache() {
+}
+
+bool Dted_Shared_Cache::Open(const string& directory) {
+    Close();
+
+    for (size_t slash = directory.find('/', 1); slash != string::npos;
+            slash = directory.find('/', slash + 1))
+        mkdir(directory.substr(0, slash).c_str(), 0755);
+
+    if ((mkdir(directory.c_str(), 0755) != 0) && (errno != EEXIST)) {
+        cerr << "ERROR: Can not create directory: '" << directory << "'"
+                << endl;
+        return false;
+    }
+
+    cacheDirectory = directory;
+
+    return true;
+}
+
+void Dted_Shared_Cache::Close() {
+    cacheDirectory.clear();
+}
+
+bool Dted_Shared_Cache::Is_Open() const {
+    return !cacheDirectory.empty();
+}
+
+string Dted_Shared_Cache::Cache_Path(const string& sourcePath,
+        const struct stat& sourceStat) const {
+    // FNV-1a of the source path.
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < sourcePath.length(); i++) {
+        hash ^= (unsigned char) sourcePath[i];
+        hash *= 1099511628211ULL;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx_%llx_%llx.dtp", hash,
+            (unsigned long long) sourceStat.st_size,
+            (unsigned long long) sourceStat.st_mtime);
+
+    return cacheDirectory + name;
+}
+
+bool Dted_Shared_Cache::Is_Packed(const string& sourcePath) {
+    char magic[sizeof(((Dted_Packed_Header*) 0)->magic)];
+    ifstream sourceStr(sourcePath.c_str(), ios::in | ios::binary);
+
+    sourceStr.read(magic, sizeof(magic));
+
+    return (sourceStr.gcount() == (streamsize) sizeof(magic))
+            && Dted_Packed_Header::Has_Magic(magic);
+}
+
+Dted_Cell* Dted_Shared_Cache::Open_Cell(const string& cachePath) {
+    Dted_Cell* dtedCellPtr = new Dted_Cell(cachePath);
+
+    if (!dtedCellPtr->isPacked() || !dtedCellPtr->isResident()) {
+        delete dtedCellPtr;
+        return NULL;
+    }
+
+    return dtedCellPtr;
+}
+
+Dted_Cell* Dted_Shared_Cache::Create_Cell(
+        const Dted_Cell_Path_Entry& dtedCellPathEntry) {
+    if (!Is_Open() || dtedCellPathEntry.archive
+            || Is_Packed(dtedCellPathEntry.cellPath))
+        return NULL;
+
+    struct stat sourceStat;
+
+    if (stat(dtedCellPathEntry.cellPath.c_str(), &sourceStat) != 0)
+        return NULL;
+
+    string cachePath = Cache_Path(dtedCellPathEntry.cellPath, sourceStat);
+
+    // Files are renamed into place complete, so one that exists is valid.
+    if (access(cachePath.c_str(), R_OK) == 0)
+        return Open_Cell(cachePath);
+
+    string lockPath = cachePath + ".lock";
+    int lockFd;
+
+    for (;;) {
+        lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+
+        if (lockFd < 0)
+            return NULL;
+
+        while ((flock(lockFd, LOCK_EX) != 0) && (errno == EINTR))
+            ;
+
+        // The previous holder removes the lock file; only a lock on the
+        // file still at lockPath serializes the decode.
+        struct stat lockStat;
+        struct stat pathStat;
+
+        if ((fstat(lockFd, &lockStat) == 0)
+                && (stat(lockPath.c_str(), &pathStat) == 0)
+                && (lockStat.st_dev == pathStat.st_dev)
+                && (lockStat.st_ino == pathStat.st_ino))
+            break;
+
+        close(lockFd);
+    }
+
+    // The previous holder of the lock may have decoded it.
+    bool cached = (access(cachePath.c_str(), R_OK) == 0);
+
+    if (!cached) {
+        Dted_Cell sourceCell(dtedCellPathEntry.cellPath);
+
+        cached = (sourceCell.getDataRegionSize() != 0)
+                && sourceCell.writePacked(cachePath);
+    }
+
+    // Remove the lock file while holding it, so that none is left behind.
+    unlink(lockPath.c_str());
+
+    flock(lockFd, LOCK_UN);
+    close(lockFd);
+
+    return cached ? Open_Cell(cachePath) : NULL;
+}
@@ -0,0 +1,77 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Cache of decoded Dted cells shared by the processes of a
+//               node.  Each cell is decoded once into a packed cell file
+//               (see Dted_Packed_Format.h) in a directory on a shared
+//               memory file system such as /dev/shm, which every process
+//               then maps read-only, so the posts are held once per node.
+//               An flock on a per-cell lock file elects the process that
+//               decodes a cell; the others wait for it and map its result.
+//               The locks are released if the decoding process dies.
+//
+//********************************************************************
+
+#ifndef Dted_Shared_Cache_H
+#define Dted_Shared_Cache_H
+
+#include <sys/stat.h>
+
+#include <string>
+
+#include "Dted_Cell_Path_Entry.h"
+
+using namespace std;
+
+class Dted_Cell;
+
+class Dted_Shared_Cache {
+public:
+
+    Dted_Shared_Cache();
+
+    /*! Use a cache directory, creating it if needed.
+     @param directory cache directory, best on a tmpfs.
+     @return Returns true on success, false on error.
+     */
+    bool Open(const string& directory);
+
+    //! Stop using the cache.  Cells already mapped stay valid.
+    void Close();
+
+    //! Returns true if a cache directory is in use.
+    bool Is_Open() const;
+
+    /*! Map a directory entry's cell from the cache, decoding it into the
+     cache first if no process has.  Packed and archived cells are
+     mapped already and are not cached.
+     @return the packed cell, or NULL if the cell can not be cached.
+     */
+    Dted_Cell* Create_Cell(const Dted_Cell_Path_Entry& dtedCellPathEntry);
+
+private:
+
+    Dted_Shared_Cache(const Dted_Shared_Cache&);
+    const Dted_Shared_Cache& operator=(const Dted_Shared_Cache&);
+
+    //! Cache file of a source file.  The name changes with the source's
+    //! size and modification time, so updated files are decoded anew.
+    string Cache_Path(const string& sourcePath,
+            const struct stat& sourceStat) const;
+
+    //! Returns true if the source is a packed cell, mapped already.
+    static bool Is_Packed(const string& sourcePath);
+
+    //! Map a cache file, NULL if it is not a valid packed cell.
+    static Dted_Cell* Open_Cell(const string& cachePath);
+
+    string cacheDirectory;
+};
+
+#endif
@@ -0,0 +1,57 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Layout of a Dted_Database snapshot.  A snapshot starts
+//               with a header page listing one section per Dted level.
+//               A section holds the level's directory, as written by
+//               Dted_Directory::Save_Directory(), and an archive of the
+//               cells loaded when the snapshot was taken (see
+//               Dted_Archive.h), starting on a page boundary.  Restoring
+//               a snapshot maps the archived cells instead of reading
+//               Dted files.
+//
+//********************************************************************
+
+#ifndef Dted_Snapshot_Format_H
+#define Dted_Snapshot_Format_H
+
+#include <string.h>
+
+struct Dted_Snapshot_Header {
+    enum {
+        VERSION = 1,
+        MAX_LEVELS = 3
+    };
+
+    struct Level_Section {
+        //! Dted_Level of the section.
+        int level;
+        unsigned int reserved;
+        unsigned long long directoryOffset;
+        unsigned long long directorySize;
+        //! Offset of the archive of loaded cells.
+        unsigned long long archiveOffset;
+    };
+
+    //! "DTEDSNAP"
+    char magic[8];
+    unsigned int version;
+    //! Dted_Packed_Header::BYTE_ORDER_MARK in the writer's byte order.
+    unsigned int byteOrder;
+    unsigned int levelCount;
+    unsigned int reserved;
+    Level_Section levels[MAX_LEVELS];
+
+    //! Returns true if buffer starts with the snapshot magic.
+    static bool Has_Magic(const char* buffer) {
+        return memcmp(buffer, "DTEDSNAP", 8) == 0;
+    }
+};
+
+#endif
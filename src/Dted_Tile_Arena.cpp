@@ -0,0 +1,137 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Arena for the resident posts of Dted cells.
+//
+//********************************************************************
+
+#include <sys/mman.h>
+
+#include "Dted_Numa.h"
+#include "Dted_Tile_Arena.h"
+
+Dted_Tile_Arena::Dted_Tile_Arena() :
+        slabCursor(NULL),
+        slabRemaining(0),
+        hugeTlb(false),
+        arenaNode(-1) {
+}
+
+Dted_Tile_Arena::~Dted_Tile_Arena() {
+    for (size_t i = 0; i < slabs.size(); i++)
+        munmap(slabs[i].base, slabs[i].size);
+}
+
+void Dted_Tile_Arena::Set_Huge_Tlb(bool newState) {
+    boost::mutex::scoped_lock lock(arenaMutex);
+    hugeTlb = newState;
+}
+
+void Dted_Tile_Arena::Set_Node(int node) {
+    boost::mutex::scoped_lock lock(arenaMutex);
+    arenaNode = node;
+}
+
+bool Dted_Tile_Arena::Map_Slab(size_t size) {
+    size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    void* region = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (hugeTlb)
+        region = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    if (region == MAP_FAILED) {
+        // Over-map to align the slab on a huge page boundary.
+        size_t mappedSize = size + HUGE_PAGE_SIZE;
+        unsigned char* mapped = (unsigned char*) mmap(NULL, mappedSize,
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (mapped == MAP_FAILED)
+            return false;
+
+        unsigned char* aligned = (unsigned char*) (((size_t) mapped
+                + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+
+        if (aligned > mapped)
+            munmap(mapped, aligned - mapped);
+
+        if (aligned + size < mapped + mappedSize)
+            munmap(aligned + size, mapped + mappedSize - (aligned + size));
+
+        region = aligned;
+
+#ifdef MADV_HUGEPAGE
+        madvise(region, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    // Before any page is touched, so every page lands on the node.
+    if (arenaNode >= 0)
+        Dted_Numa::Bind_Memory(region, size, arenaNode);
+
+    Slab slab;
+    slab.base = (unsigned char*) region;
+    slab.size = size;
+    slabs.push_back(slab);
+
+    slabCursor = slab.base;
+    slabRemaining = size;
+
+    return true;
+}
+
+void* Dted_Tile_Arena::Allocate(size_t size) {
+    size = (size + SIZE_CLASS - 1) / SIZE_CLASS * SIZE_CLASS;
+
+    boost::mutex::scoped_lock lock(arenaMutex);
+
+    map<size_t, vector<void*> >::iterator it = freeBlocks.find(size);
+
+    if ((it != freeBlocks.end()) && !it->second.empty()) {
+        void* block = it->second.back();
+        it->second.pop_back();
+        return block;
+    }
+
+    // The rest of the current slab is abandoned when a block does not
+    // fit; blocks are few and large, so little is lost.
+    if ((size > slabRemaining)
+            && !Map_Slab(size > SLAB_SIZE ? size : (size_t) SLAB_SIZE))
+        return NULL;
+
+    void* block = slabCursor;
+    slabCursor += size;
+    slabRemaining -= size;
+
+    return block;
+}
+
+void Dted_Tile_Arena::Free(void* block, size_t size) {
+    if (block == NULL)
+        return;
+
+    size = (size + SIZE_CLASS - 1) / SIZE_CLASS * SIZE_CLASS;
+
+    boost::mutex::scoped_lock lock(arenaMutex);
+    freeBlocks[size].push_back(block);
+}
+
+size_t Dted_Tile_Arena::Get_Mapped_Size() const {
+    boost::mutex::scoped_lock lock(arenaMutex);
+
+    size_t mappedSize = 0;
+
+    for (size_t i = 0; i < slabs.size(); i++)
+        mappedSize += slabs[i].size;
+
+    return mappedSize;
+}
@@ -0,0 +1,93 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Arena for the resident posts of Dted cells.  Posts are
+//               carved from large slabs backed by huge pages where the
+//               system allows (MAP_HUGETLB when requested, otherwise
+//               transparent huge pages), so random lookups over many
+//               cells take far fewer TLB misses than with one malloc per
+//               cell.  Freed blocks are kept on a free list per size
+//               class and reused by the next cell of the same size, which
+//               covers the standard cell dimensions; slabs are returned
+//               to the system only when the arena is destroyed.
+//
+//********************************************************************
+
+#ifndef Dted_Tile_Arena_H
+#define Dted_Tile_Arena_H
+
+#include <stddef.h>
+
+#include <map>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+using namespace std;
+
+class Dted_Tile_Arena {
+public:
+
+    enum {
+        HUGE_PAGE_SIZE = 2 << 20,
+        SLAB_SIZE = 32 * HUGE_PAGE_SIZE,
+        SIZE_CLASS = 64 << 10 // Blocks are rounded up to this
+    };
+
+    Dted_Tile_Arena();
+
+    //! Unmaps the slabs.  No block may still be in use.
+    ~Dted_Tile_Arena();
+
+    //! Map new slabs with MAP_HUGETLB, falling back to transparent huge
+    //! pages if the system has no huge pages reserved.
+    void Set_Huge_Tlb(bool newState);
+
+    //! Bind slabs mapped afterwards to a NUMA node (-1 for none).
+    void Set_Node(int node);
+
+    //! Allocate a block of at least size bytes, NULL if out of memory.
+    void* Allocate(size_t size);
+
+    //! Return a block to its size class.
+    //! @param size the size it was allocated with.
+    void Free(void* block, size_t size);
+
+    //! Bytes of slabs mapped.
+    size_t Get_Mapped_Size() const;
+
+private:
+
+    Dted_Tile_Arena(const Dted_Tile_Arena&);
+    const Dted_Tile_Arena& operator=(const Dted_Tile_Arena&);
+
+    struct Slab {
+        unsigned char* base;
+        size_t size;
+    };
+
+    //! Map a slab of at least size bytes.
+    bool Map_Slab(size_t size);
+
+    mutable boost::mutex arenaMutex;
+
+    vector<Slab> slabs;
+
+    //! Unused end of the last slab.
+    unsigned char* slabCursor;
+    size_t slabRemaining;
+
+    //! Free blocks by rounded size.
+    map<size_t, vector<void*> > freeBlocks;
+
+    bool hugeTlb;
+    int arenaNode;
+};
+
+#endif
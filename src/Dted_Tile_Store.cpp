@@ -0,0 +1,70 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Tiles of one Dted level.
+//
+//********************************************************************
+
+#include "Dted_Tile_Store.h"
+
+namespace {
+
+//! One nautical mile per arc minute of latitude.
+const double METERS_PER_ARC_SECOND = 1852.0 / 60.0;
+
+}
+
+Dted_Level_Store::Dted_Level_Store(Dted_Level level, const char* name,
+        int latPoints, int latSpacing) :
+        level(level),
+        name(name),
+        latPoints(latPoints),
+        latSpacing(latSpacing) {
+    directory.Clear_Dted_Directory();
+}
+
+Dted_Level Dted_Level_Store::Get_Level() const {
+    return level;
+}
+
+const char* Dted_Level_Store::Get_Name() const {
+    return name;
+}
+
+int Dted_Level_Store::Get_Lat_Points() const {
+    return latPoints;
+}
+
+double Dted_Level_Store::Get_Lat_Spacing() const {
+    return latSpacing / 36000.0;
+}
+
+double Dted_Level_Store::Get_Post_Spacing() const {
+    return latSpacing / 10.0 * METERS_PER_ARC_SECOND;
+}
+
+Dted_Directory& Dted_Level_Store::Directory() {
+    return directory;
+}
+
+Dted_Cell_Grid& Dted_Level_Store::Cell_Grid() {
+    return cellGrid;
+}
+
+const Dted_Cell_Grid& Dted_Level_Store::Cell_Grid() const {
+    return cellGrid;
+}
+
+Dted_Coverage& Dted_Level_Store::Coverage() {
+    return coverage;
+}
+
+const Dted_Coverage& Dted_Level_Store::Coverage() const {
+    return coverage;
+}
@@ -0,0 +1,90 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Tiles of one Dted level: the directory of its cells,
+//               the lock-free grid of the loaded cells and the coverage
+//               bitmap.  Dted_Tile_Store is instantiated once per level
+//               from its Dted_Level_Traits; the database reaches every
+//               level through the common Dted_Level_Store so that all
+//               levels share one query path.
+//
+//********************************************************************
+
+#ifndef Dted_Tile_Store_H
+#define Dted_Tile_Store_H
+
+#include "Dted_Cell_Grid.h"
+#include "Dted_Common.h"
+#include "Dted_Coverage.h"
+#include "Dted_Directory.h"
+#include "Dted_Level_Traits.h"
+
+class Dted_Level_Store {
+public:
+
+    /*! Describe a level.
+     @param level Dted level of the tiles.
+     @param name level name for reports, e.g. "DTED1".
+     @param latPoints posts per longitude line.
+     @param latSpacing post spacing along a longitude line, in tenths
+     of arc seconds.
+     */
+    Dted_Level_Store(Dted_Level level, const char* name, int latPoints,
+            int latSpacing);
+
+    Dted_Level Get_Level() const;
+
+    const char* Get_Name() const;
+
+    //! Posts per longitude line of the level's cells.
+    int Get_Lat_Points() const;
+
+    //! Post spacing along a longitude line, in degrees.
+    double Get_Lat_Spacing() const;
+
+    //! Nominal ground distance between posts, in meters.
+    double Get_Post_Spacing() const;
+
+    //! Cells available on disk.
+    Dted_Directory& Directory();
+
+    //! Loaded cells.
+    Dted_Cell_Grid& Cell_Grid();
+    const Dted_Cell_Grid& Cell_Grid() const;
+
+    //! Cells of the directory, tested without a lock.
+    Dted_Coverage& Coverage();
+    const Dted_Coverage& Coverage() const;
+
+private:
+
+    Dted_Level_Store(const Dted_Level_Store&);
+    const Dted_Level_Store& operator=(const Dted_Level_Store&);
+
+    Dted_Level level;
+    const char* name;
+    int latPoints;
+    int latSpacing;
+
+    Dted_Directory directory;
+    Dted_Cell_Grid cellGrid;
+    Dted_Coverage coverage;
+};
+
+template<class Traits>
+class Dted_Tile_Store: public Dted_Level_Store {
+public:
+
+    Dted_Tile_Store() :
+            Dted_Level_Store((Dted_Level) Traits::LEVEL, Traits::Name(),
+                    Traits::LAT_POINTS, Traits::LAT_SPACING) {
+    }
+};
+
+#endif
@@ -0,0 +1,309 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Predictive prefetcher for a moving platform.
+//
+//********************************************************************
+
+#include <math.h>
+
+#include "Dted_Trajectory_Prefetcher.h"
+
+namespace {
+
+const double METERS_PER_DEGREE = 111320.0;
+const double DEGREES_TO_RADIANS = M_PI / 180.0;
+
+double Normalize_Longitude(double lon) {
+    while (lon >= 180.0)
+        lon -= 360.0;
+
+    while (lon < -180.0)
+        lon += 360.0;
+
+    return lon;
+}
+
+}
+
+Dted_Trajectory_Prefetcher::Dted_Trajectory_Prefetcher(
+        Dted_Database& database, Dted_Level level, double lookaheadSeconds) :
+        theDatabase(database),
+        theLevel(level),
+        theLookahead(lookaheadSeconds),
+        theCursorValid(false),
+        thePosition(),
+        theNorthVelocity(0.0),
+        theEastVelocity(0.0),
+        theObservationValid(false),
+        theLastObservation(),
+        theLastObservationTime(0.0),
+        theGroundSpeed(0.0) {
+}
+
+Dted_Trajectory_Prefetcher::~Dted_Trajectory_Prefetcher() {
+    theHandle.Cancel();
+}
+
+void Dted_Trajectory_Prefetcher::Set_Lookahead(double lookaheadSeconds) {
+    theLookahead = lookaheadSeconds;
+
+    if (theCursorValid || !theWaypoints.empty())
+        Predict();
+}
+
+void Dted_Trajectory_Prefetcher::Observe(const Geo_Location& position,
+        double timeSeconds) {
+    double northVelocity = theNorthVelocity;
+    double eastVelocity = theEastVelocity;
+
+    if (theObservationValid && (timeSeconds > theLastObservationTime)) {
+        double dt = timeSeconds - theLastObservationTime;
+        double metersPerDegreeLon = METERS_PER_DEGREE
+                * cos(position.lat * DEGREES_TO_RADIANS);
+
+        northVelocity = (position.lat - theLastObservation.lat)
+                * METERS_PER_DEGREE / dt;
+        eastVelocity = Normalize_Longitude(
+                position.lon - theLastObservation.lon) * metersPerDegreeLon
+                / dt;
+    }
+
+    theObservationValid = true;
+    theLastObservation = position;
+    theLastObservationTime = timeSeconds;
+
+    Update_Cursor(position, northVelocity, eastVelocity);
+}
+
+void Dted_Trajectory_Prefetcher::Update_Cursor(const Geo_Location& position,
+        double northVelocity, double eastVelocity) {
+    theCursorValid = true;
+    thePosition = position;
+    theNorthVelocity = northVelocity;
+    theEastVelocity = eastVelocity;
+
+    Predict();
+}
+
+void Dted_Trajectory_Prefetcher::Set_Waypoints(
+        const vector<Geo_Location>& waypoints, double groundSpeed) {
+    theWaypoints = waypoints;
+    theGroundSpeed = groundSpeed;
+
+    Predict();
+}
+
+void Dted_Trajectory_Prefetcher::Clear_Waypoints() {
+    theWaypoints.clear();
+
+    Predict();
+}
+
+void Dted_Trajectory_Prefetcher::Cancel() {
+    theHandle.Cancel();
+
+    theCursorValid = false;
+    theObservationValid = false;
+    thePredictedCells.clear();
+}
+
+Dted_Load_Handle Dted_Trajectory_Prefetcher::Get_Handle() const {
+    return theHandle;
+}
+
+const vector<Geo_Location>& Dted_Trajectory_Prefetcher::Get_Predicted_Cells() const {
+    return thePredictedCells;
+}
+
+double Dted_Trajectory_Prefetcher::Distance(const Geo_Location& from,
+        const Geo_Location& to) {
+    double meanLat = (from.lat + to.lat) / 2.0;
+    double dNorth = (to.lat - from.lat) * METERS_PER_DEGREE;
+    double dEast = Normalize_Longitude(to.lon - from.lon) * METERS_PER_DEGREE
+            * cos(meanLat * DEGREES_TO_RADIANS);
+
+    return sqrt(dNorth * dNorth + dEast * dEast);
+}
+
+void Dted_Trajectory_Prefetcher::Trace_Segment(const Geo_Location& start,
+        const Geo_Location& end, vector<Geo_Location>& cells) {
+    // Walk the one degree grid cells crossed by the segment (2D DDA).
+    double x0 = start.lon;
+    double y0 = start.lat;
+    double dx = Normalize_Longitude(end.lon - start.lon);
+    double dy = end.lat - start.lat;
+
+    int cellX = (int) floor(x0);
+    int cellY = (int) floor(y0);
+    int endX = (int) floor(x0 + dx);
+    int endY = (int) floor(y0 + dy);
+
+    int stepX = (dx > 0.0) ? 1 : -1;
+    int stepY = (dy > 0.0) ? 1 : -1;
+
+    double tMaxX = HUGE_VAL;
+    double tMaxY = HUGE_VAL;
+    double tDeltaX = HUGE_VAL;
+    double tDeltaY = HUGE_VAL;
+
+    if (dx != 0.0) {
+        tMaxX = (((dx > 0.0) ? cellX + 1 : cellX) - x0) / dx;
+        tDeltaX = 1.0 / fabs(dx);
+    }
+
+    if (dy != 0.0) {
+        tMaxY = (((dy > 0.0) ? cellY + 1 : cellY) - y0) / dy;
+        tDeltaY = 1.0 / fabs(dy);
+    }
+
+    int steps = abs(endX - cellX) + abs(endY - cellY);
+
+    for (int i = 0; i <= steps; i++) {
+        if ((cellY >= -90) && (cellY < 90)) {
+            Geo_Location corner;
+            corner.lat = cellY;
+            corner.lon = Normalize_Longitude(cellX);
+
+            bool known = false;
+
+            for (size_t j = 0; (j < cells.size()) && !known; j++)
+                known = (cells[j].lat == corner.lat)
+                        && (cells[j].lon == corner.lon);
+
+            if (!known)
+                cells.push_back(corner);
+        }
+
+        if (tMaxX < tMaxY) {
+            cellX += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cellY += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+}
+
+void Dted_Trajectory_Prefetcher::Predict() {
+    vector<Geo_Location> cells;
+
+    if (!theWaypoints.empty()) {
+        // Project the cursor onto the path to find the progress along it.
+        size_t segment = 0;
+        Geo_Location start = theWaypoints[0];
+
+        if (theCursorValid && (theWaypoints.size() > 1)) {
+            double bestDistance = HUGE_VAL;
+
+            for (size_t i = 0; i + 1 < theWaypoints.size(); i++) {
+                const Geo_Location& a = theWaypoints[i];
+                const Geo_Location& b = theWaypoints[i + 1];
+                double scale = cos(a.lat * DEGREES_TO_RADIANS);
+                double abx = Normalize_Longitude(b.lon - a.lon) * scale;
+                double aby = b.lat - a.lat;
+                double apx = Normalize_Longitude(thePosition.lon - a.lon)
+                        * scale;
+                double apy = thePosition.lat - a.lat;
+                double length2 = abx * abx + aby * aby;
+                double t = (length2 > 0.0) ?
+                        (apx * abx + apy * aby) / length2 : 0.0;
+
+                t = (t < 0.0) ? 0.0 : ((t > 1.0) ? 1.0 : t);
+
+                Geo_Location projected;
+                projected.lat = a.lat + t * (b.lat - a.lat);
+                projected.lon = Normalize_Longitude(
+                        a.lon + t * Normalize_Longitude(b.lon - a.lon));
+
+                double distance = Distance(thePosition, projected);
+
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    segment = i;
+                    start = projected;
+                }
+            }
+        } else if (theCursorValid) {
+            start = thePosition;
+        }
+
+        double remaining = theGroundSpeed * theLookahead;
+        Geo_Location current = start;
+
+        Trace_Segment(current, current, cells);
+
+        for (size_t i = segment; (i + 1 < theWaypoints.size())
+                && (remaining > 0.0); i++) {
+            const Geo_Location& next = theWaypoints[i + 1];
+            double length = Distance(current, next);
+
+            if (length >= remaining) {
+                double t = remaining / length;
+                Geo_Location end;
+                end.lat = current.lat + t * (next.lat - current.lat);
+                end.lon = Normalize_Longitude(
+                        current.lon
+                                + t * Normalize_Longitude(
+                                        next.lon - current.lon));
+
+                Trace_Segment(current, end, cells);
+                remaining = 0.0;
+            } else {
+                Trace_Segment(current, next, cells);
+                remaining -= length;
+                current = next;
+            }
+        }
+    } else if (theCursorValid) {
+        // Dead reckoning along the current velocity.
+        double metersPerDegreeLon = METERS_PER_DEGREE
+                * cos(thePosition.lat * DEGREES_TO_RADIANS);
+
+        Geo_Location end;
+        end.lat = thePosition.lat
+                + theNorthVelocity * theLookahead / METERS_PER_DEGREE;
+        end.lon = thePosition.lon;
+
+        if (metersPerDegreeLon > 0.0)
+            end.lon += theEastVelocity * theLookahead / metersPerDegreeLon;
+
+        if (end.lat > 89.999999)
+            end.lat = 89.999999;
+        else if (end.lat < -90.0)
+            end.lat = -90.0;
+
+        end.lon = Normalize_Longitude(end.lon);
+
+        Trace_Segment(thePosition, end, cells);
+    }
+
+    bool changed = (cells.size() != thePredictedCells.size());
+
+    for (size_t i = 0; (i < cells.size()) && !changed; i++)
+        changed = (cells[i].lat != thePredictedCells[i].lat)
+                || (cells[i].lon != thePredictedCells[i].lon);
+
+    if (!changed)
+        return;
+
+    // The path changed: drop loads that have not started and reissue.
+    theHandle.Cancel();
+    thePredictedCells = cells;
+
+    vector<Geo_Location> centers(cells);
+
+    for (size_t i = 0; i < centers.size(); i++) {
+        centers[i].lat += 0.5;
+        centers[i].lon += 0.5;
+    }
+
+    theHandle = theDatabase.Prefetch_Cells(centers, theLevel,
+            LOAD_SPECULATIVE);
+}
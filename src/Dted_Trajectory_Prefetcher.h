@@ -0,0 +1,118 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Predictive prefetcher for a moving platform.  Tracks a
+//               cursor (either from observed query positions, an
+//               explicit velocity or a waypoint list) and keeps the
+//               cells it will enter within the lookahead time loading
+//               in the background.  A prefetcher is driven by a single
+//               thread; use one per platform.
+//
+//********************************************************************
+
+#ifndef Dted_Trajectory_Prefetcher_H
+#define Dted_Trajectory_Prefetcher_H
+
+#include <vector>
+
+#include "Dted_Common.h"
+#include "Dted_Database.h"
+
+using namespace std;
+
+class Dted_Trajectory_Prefetcher {
+public:
+
+    /*! Constructor.
+     @param database database whose cells are prefetched.
+     @param level Dted level to prefetch.
+     @param lookaheadSeconds how far ahead of the cursor to load.
+     */
+    Dted_Trajectory_Prefetcher(Dted_Database& database, Dted_Level level,
+            double lookaheadSeconds);
+
+    //! Cancels the outstanding prefetch.
+    ~Dted_Trajectory_Prefetcher();
+
+    //! Set the lookahead time in seconds.
+    void Set_Lookahead(double lookaheadSeconds);
+
+    /*! Report a queried position.  The velocity is estimated from
+     successive observations.
+     @param position position of the cursor.
+     @param timeSeconds time of the observation.
+     */
+    void Observe(const Geo_Location& position, double timeSeconds);
+
+    /*! Report the cursor position and velocity.
+     @param position position of the cursor.
+     @param northVelocity velocity towards north in meters per second.
+     @param eastVelocity velocity towards east in meters per second.
+     */
+    void Update_Cursor(const Geo_Location& position, double northVelocity,
+            double eastVelocity);
+
+    /*! Follow a waypoint list instead of dead reckoning.  Cursor updates
+     then only advance the progress along the path.
+     @param waypoints path of the platform.
+     @param groundSpeed speed along the path in meters per second.
+     */
+    void Set_Waypoints(const vector<Geo_Location>& waypoints,
+            double groundSpeed);
+
+    //! Return to dead reckoning from the cursor velocity.
+    void Clear_Waypoints();
+
+    //! Cancel the outstanding prefetch and forget the cursor.
+    void Cancel();
+
+    //! Handle of the outstanding prefetch.
+    Dted_Load_Handle Get_Handle() const;
+
+    //! South west corners of the cells currently predicted, in order.
+    const vector<Geo_Location>& Get_Predicted_Cells() const;
+
+private:
+
+    Dted_Trajectory_Prefetcher(const Dted_Trajectory_Prefetcher&);
+    const Dted_Trajectory_Prefetcher& operator=(
+            const Dted_Trajectory_Prefetcher&);
+
+    //! Recompute the predicted cells and reissue the prefetch if the
+    //! prediction changed.
+    void Predict();
+
+    //! Append the cells crossed by the segment from start to end.
+    static void Trace_Segment(const Geo_Location& start,
+            const Geo_Location& end, vector<Geo_Location>& cells);
+
+    //! Great circle approximation of the distance in meters.
+    static double Distance(const Geo_Location& from, const Geo_Location& to);
+
+    Dted_Database& theDatabase;
+    Dted_Level theLevel;
+    double theLookahead;
+
+    bool theCursorValid;
+    Geo_Location thePosition;
+    double theNorthVelocity;
+    double theEastVelocity;
+
+    bool theObservationValid;
+    Geo_Location theLastObservation;
+    double theLastObservationTime;
+
+    vector<Geo_Location> theWaypoints;
+    double theGroundSpeed;
+
+    vector<Geo_Location> thePredictedCells;
+    Dted_Load_Handle theHandle;
+};
+
+#endif
@@ -0,0 +1,137 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Record of the Dted cells queried during a session.
+//
+//********************************************************************
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "Dted_Cell_Grid.h"
+#include "Dted_Working_Set.h"
+
+Dted_Working_Set::Dted_Working_Set() :
+        accessCounts(NULL) {
+}
+
+Dted_Working_Set::~Dted_Working_Set() {
+    delete[] accessCounts;
+}
+
+void Dted_Working_Set::Reset() {
+    boost::mutex::scoped_lock lock(orderMutex);
+
+    int numSlots = NUM_LEVELS * NUM_PARALLELS * NUM_MERIDIANS;
+
+    if (accessCounts == NULL)
+        accessCounts = new boost::atomic<unsigned int>[numSlots];
+
+    for (int i = 0; i < numSlots; i++)
+        accessCounts[i].store(0, boost::memory_order_relaxed);
+
+    firstAccessOrder.clear();
+}
+
+void Dted_Working_Set::Record(Dted_Level level, const Geo_Location& geoLoc) {
+    short latitude;
+    short longitude;
+
+    Dted_Cell_Grid::Cell_Corner(geoLoc, latitude, longitude);
+
+    if ((accessCounts == NULL) || (level < 0) || (level >= (int) NUM_LEVELS)
+            || !Dted_Cell_Grid::Is_Valid(latitude, longitude))
+        return;
+
+    int slot = Slot_Index(level, latitude, longitude);
+
+    if (accessCounts[slot].fetch_add(1, boost::memory_order_relaxed) == 0) {
+        boost::mutex::scoped_lock lock(orderMutex);
+        firstAccessOrder.push_back(slot);
+    }
+}
+
+void Dted_Working_Set::Get_Entries(vector<Entry>& entries) const {
+    boost::mutex::scoped_lock lock(orderMutex);
+
+    for (size_t i = 0; i < firstAccessOrder.size(); i++) {
+        int slot = firstAccessOrder[i];
+        int row = slot / NUM_MERIDIANS;
+
+        Entry entry;
+        entry.level = (Dted_Level) (row / NUM_PARALLELS);
+        entry.latitude = row % NUM_PARALLELS - NUM_PARALLELS / 2;
+        entry.longitude = slot % NUM_MERIDIANS - NUM_MERIDIANS / 2;
+        entry.accessCount = accessCounts[slot].load(
+                boost::memory_order_relaxed);
+
+        entries.push_back(entry);
+    }
+}
+
+bool Dted_Working_Set::Save(const string& path) const {
+    vector<Entry> entries;
+    Get_Entries(entries);
+
+    string tempPath = path + ".tmp";
+    ofstream workingSetStr(tempPath.c_str(), ios::out | ios::trunc);
+
+    if (!workingSetStr.is_open())
+        return false;
+
+    workingSetStr << "# level latitude longitude count" << endl;
+
+    for (size_t i = 0; i < entries.size(); i++)
+        workingSetStr << entries[i].level << " " << entries[i].latitude << " "
+                << entries[i].longitude << " " << entries[i].accessCount
+                << endl;
+
+    workingSetStr.close();
+
+    if (workingSetStr.fail() || (rename(tempPath.c_str(), path.c_str()) != 0)) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool Dted_Working_Set::Load(const string& path, vector<Entry>& entries) {
+    ifstream workingSetStr(path.c_str());
+
+    if (!workingSetStr.is_open())
+        return false;
+
+    string line;
+
+    while (getline(workingSetStr, line)) {
+        if (line.empty() || (line[0] == '#'))
+            continue;
+
+        istringstream lineStr(line);
+        int level;
+        Entry entry;
+
+        if (!(lineStr >> level >> entry.latitude >> entry.longitude
+                >> entry.accessCount) || (level < 0) || (level >= NUM_LEVELS)
+                || !Dted_Cell_Grid::Is_Valid(entry.latitude, entry.longitude)) {
+            cerr << "ERROR: Invalid working set line: '" << line << "' in: '"
+                    << path << "'" << endl;
+            return false;
+        }
+
+        entry.level = (Dted_Level) level;
+        entries.push_back(entry);
+    }
+
+    return true;
+}
@@ -0,0 +1,84 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Record of the Dted cells queried during a session, in
+//               the order they were first queried, with their query
+//               counts.  Saved as a text file, one "level latitude
+//               longitude count" line per cell, which can be replayed to
+//               preload the same cells at the start of a later session.
+//
+//********************************************************************
+
+#ifndef Dted_Working_Set_H
+#define Dted_Working_Set_H
+
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "Dted_Common.h"
+
+using namespace std;
+
+class Dted_Working_Set {
+public:
+
+    enum {
+        NUM_LEVELS = 3, NUM_PARALLELS = 180, NUM_MERIDIANS = 360
+    };
+
+    //! A cell of the working set.
+    struct Entry {
+        Dted_Level level;
+        short latitude;
+        short longitude;
+        unsigned int accessCount;
+    };
+
+    Dted_Working_Set();
+    ~Dted_Working_Set();
+
+    //! Forget the cells recorded so far.
+    void Reset();
+
+    //! Count a query of the cell covering geoLoc.
+    void Record(Dted_Level level, const Geo_Location& geoLoc);
+
+    //! The recorded cells in the order they were first queried.
+    void Get_Entries(vector<Entry>& entries) const;
+
+    //! Write the recorded cells to a file.
+    //! @return Returns true on success, false on error.
+    bool Save(const string& path) const;
+
+    //! Read the cells of a working set file.
+    //! @return Returns true on success, false on error.
+    static bool Load(const string& path, vector<Entry>& entries);
+
+private:
+
+    Dted_Working_Set(const Dted_Working_Set&);
+    const Dted_Working_Set& operator=(const Dted_Working_Set&);
+
+    static int Slot_Index(Dted_Level level, short latitude, short longitude) {
+        return (level * NUM_PARALLELS + latitude + NUM_PARALLELS / 2)
+                * NUM_MERIDIANS + (longitude + NUM_MERIDIANS / 2);
+    }
+
+    //! Query count per cell of every level, allocated by Reset().
+    boost::atomic<unsigned int>* accessCounts;
+
+    //! Slots in the order of their first query, guarded by orderMutex.
+    mutable boost::mutex orderMutex;
+    vector<int> firstAccessOrder;
+};
+
+#endif
@@ -0,0 +1,59 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Command line tool packing every cell of a Dted tree
+//               (Dted or packed cells) into a single archive file.
+//
+//               usage: dted_archive <dted directory> <archive file>
+//
+//********************************************************************
+
+#include <iostream>
+#include <vector>
+
+#include "Dted_Archive.h"
+#include "Dted_Directory.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "usage: " << argv[0] << " <dted directory> <archive file>"
+                << endl;
+        return 2;
+    }
+
+    Dted_Directory directory;
+    directory.Populate_Directory(argv[1]);
+
+    vector<Dted_Cell_Path_Entry> cellEntries;
+    Dted_Cell_Path_Entry cellEntry;
+
+    directory.QueryReset();
+
+    while (directory.Query(cellEntry))
+        cellEntries.push_back(cellEntry);
+
+    if (cellEntries.empty()) {
+        cerr << "No DTED cells found in '" << argv[1] << "'" << endl;
+        return 1;
+    }
+
+    int failed = Dted_Archive::Build(cellEntries, argv[2]);
+
+    if (failed < 0) {
+        cerr << "Can not write '" << argv[2] << "'" << endl;
+        return 1;
+    }
+
+    cout << cellEntries.size() - failed << " cells archived, " << failed
+            << " failed" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
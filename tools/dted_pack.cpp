@@ -0,0 +1,47 @@
+//*******************************************************************
+// Copyright (C) 2006 Free Software Foundation
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Author: Harlan Murphy
+//
+// Description:  Command line tool converting a Dted tree into a tree of
+//               packed cells.
+//
+//               usage: dted_pack [-v] <dted directory> <packed directory>
+//
+//********************************************************************
+
+#include <string.h>
+
+#include <iostream>
+
+#include "Dted_Packed_Converter.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    Dted_Packed_Converter converter;
+    int arg = 1;
+
+    if ((argc > arg) && (strcmp(argv[arg], "-v") == 0)) {
+        converter.Set_Verbose(true);
+        arg++;
+    }
+
+    if (argc - arg != 2) {
+        cerr << "usage: " << argv[0]
+                << " [-v] <dted directory> <packed directory>" << endl;
+        return 2;
+    }
+
+    int failed = converter.Convert_Tree(argv[arg], argv[arg + 1]);
+
+    cout << converter.Get_Converted() << " converted, "
+            << converter.Get_Skipped() << " up to date, " << failed
+            << " failed" << endl;
+
+    return (failed == 0) ? 0 : 1;
+}